@@ -1,5 +1,5 @@
 
-QT       += core gui widgets network
+QT       += core gui widgets
 QT       += charts
 
 TARGET = SkiingAnalyzer
@@ -20,20 +20,30 @@ CONFIG += c++11
 
 SOURCES += \
         main.cpp \
-    skianalyzer.cpp \
         skimainwindow.cpp \
     skimodel.cpp \
     skiview.cpp \
-    skiquestionsdock.cpp \
-    skidataretriever.cpp
+    skiquestionsdock.cpp
 
 HEADERS += \
-    skianalyzer.h \
         skimainwindow.h \
     skimodel.h \
     skiview.h \
-    skiquestionsdock.h \
-    skidataretriever.h
+    skiquestionsdock.h
+
+# Retrieval and analysis are linked from the static engine library, see
+# SkiingSuite.pro
+include(skiengine.pri)
+
+win32:CONFIG(release, debug|release): ENGINE_DIR = $$OUT_PWD/engine/release
+else:win32:CONFIG(debug, debug|release): ENGINE_DIR = $$OUT_PWD/engine/debug
+else: ENGINE_DIR = $$OUT_PWD/engine
+
+LIBS += -L$$ENGINE_DIR -lSkiingEngine
+
+win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
+else:win32:!win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/SkiingEngine.lib
+else: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
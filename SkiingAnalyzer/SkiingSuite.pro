@@ -0,0 +1,22 @@
+# Builds the engine library and the application and tools linking it
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    app \
+    engine \
+    cli \
+    generator \
+    standin \
+    benchmark
+
+app.file = SkiingAnalyzer.pro
+app.depends = engine
+engine.file = engine/SkiingEngine.pro
+cli.file = cli/SkiingCli.pro
+cli.depends = engine
+generator.file = generator/SkiingGenerator.pro
+generator.depends = engine
+standin.file = standin/SkiingStandIn.pro
+standin.depends = engine
+benchmark.file = benchmark/SkiingBenchmark.pro
+benchmark.depends = engine
@@ -0,0 +1,36 @@
+QT       += testlib
+QT       -= gui
+
+TARGET = SkiingBenchmark
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The benchmark links the same engine library as the application, without
+# its user interface
+INCLUDEPATH += ../generator ../standin
+
+SOURCES += \
+    skibenchmark.cpp \
+    ../generator/skiresultgenerator.cpp \
+    ../standin/skistandinserver.cpp
+
+HEADERS += \
+    skibenchmark.h \
+    ../generator/skiresultgenerator.h \
+    ../standin/skistandinserver.h
+
+include(../skiengine.pri)
+
+win32:CONFIG(release, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/release
+else:win32:CONFIG(debug, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/debug
+else: ENGINE_DIR = $$OUT_PWD/../engine
+
+LIBS += -L$$ENGINE_DIR -lSkiingEngine
+
+win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
+else:win32:!win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/SkiingEngine.lib
+else: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
@@ -0,0 +1,451 @@
+#include "skibenchmark.h"
+#include "skiresultpageparser.h"
+#include "skiresultindex.h"
+#include "skiresultgenerator.h"
+#include "skistandinserver.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+
+#include <algorithm>
+
+namespace {
+
+// Number of years of the medium dataset
+const int MediumYears = 10;
+
+// Pages are fed to the parser in chunks of about the size of a network read
+const int PageChunkSize = 16 * 1024;
+
+// Participants of the races served to the full retrievals
+const int RefreshParticipants = 200;
+
+// Race used by the requests that need one. It has been run every year.
+const QString BenchmarkRace = "50 km traditional";
+
+}
+
+SkiBenchmark::SkiBenchmark(QObject *parent) :
+    QObject(parent),
+    m_anonymous(false)
+{}
+
+void SkiBenchmark::initTestCase()
+{
+    // Without a database file the results are generated
+    const QString filename = qEnvironmentVariable("SKI_BENCHMARK_DATA");
+    if(filename.isEmpty()){
+        m_source = SkiResultGenerator().json();
+    }
+    else{
+        QFile file(filename);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.errorString()));
+        m_source = QJsonDocument::fromJson(file.readAll()).object();
+    }
+    QVERIFY2(m_source.value("anonymous").isBool(), "Not a JSON database");
+    m_anonymous = m_source.value("anonymous").toBool();
+
+    for(auto it = m_source.constBegin(); it != m_source.constEnd(); ++it){
+        if(it.value().isObject())
+            m_years.append(it.key().toInt());
+    }
+    std::sort(m_years.begin(), m_years.end());
+    QVERIFY2(!m_years.isEmpty(), "The JSON database has no years");
+}
+
+void SkiBenchmark::cleanupTestCase()
+{
+    m_fixtures.clear();
+}
+
+void SkiBenchmark::importJson_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::importJson()
+{
+    QFETCH(QString, dataset);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("import.json");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(subset(dataset)).toJson(QJsonDocument::Compact));
+    file.close();
+
+    // The retriever writes its database file to the working directory
+    const QString current = QDir::currentPath();
+    QDir::setCurrent(dir.path());
+    SkiDataRetriever retriever(nullptr, m_anonymous);
+    bool imported = true;
+    QBENCHMARK {
+        imported = retriever.ImportData(filename) && imported;
+    }
+    QDir::setCurrent(current);
+    QVERIFY(imported);
+}
+
+void SkiBenchmark::parsePage_data()
+{
+    QTest::addColumn<QByteArray>("page");
+
+    // Without a directory of saved pages the pages are generated
+    const QString path = qEnvironmentVariable("SKI_BENCHMARK_PAGES");
+    if(path.isEmpty()){
+        const SkiResultGenerator generator;
+        const int lastYear = generator.parameters().lastYear;
+        QTest::newRow("generated") << generator.page(lastYear);
+        return;
+    }
+
+    const QDir dir(path);
+    for(const QString &name : dir.entryList(QStringList() << "*.html", QDir::Files, QDir::Name)){
+        QFile file(dir.filePath(name));
+        if(file.open(QIODevice::ReadOnly))
+            QTest::newRow(qPrintable(name)) << file.readAll();
+    }
+}
+
+void SkiBenchmark::parsePage()
+{
+    QFETCH(QByteArray, page);
+
+    SkiResultPageParser parser;
+    int records = 0;
+    QBENCHMARK {
+        parser.reset();
+        for(int pos = 0; pos < page.size(); pos += PageChunkSize)
+            parser.feed(page.mid(pos, PageChunkSize));
+        records = parser.takeRecords().size();
+    }
+    QVERIFY(parser.year() != 0);
+    QVERIFY(records > 0);
+}
+
+void SkiBenchmark::refresh_data()
+{
+    QTest::addColumn<int>("latency");
+    QTest::addColumn<int>("bandwidth");
+    QTest::addColumn<int>("errorRate");
+    QTest::addColumn<int>("dropRate");
+
+    QTest::newRow("local") << 0 << 0 << 0 << 0;
+    QTest::newRow("slow") << 50 << 1024 * 1024 << 0 << 0;
+    QTest::newRow("failing") << 0 << 0 << 10 << 5;
+}
+
+void SkiBenchmark::refresh()
+{
+    QFETCH(int, latency);
+    QFETCH(int, bandwidth);
+    QFETCH(int, errorRate);
+    QFETCH(int, dropRate);
+
+    SkiResultGenerator::Parameters parameters;
+    parameters.participants = RefreshParticipants;
+    SkiStandInServer::Options options;
+    options.latency = latency;
+    options.bandwidth = bandwidth;
+    options.errorRate = errorRate;
+    options.dropRate = dropRate;
+
+    SkiStandInServer server(parameters);
+    server.setOptions(options);
+    QVERIFY2(server.listen(), qPrintable(server.errorString()));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString current = QDir::currentPath();
+    QDir::setCurrent(dir.path());
+
+    SkiDataRetriever retriever(nullptr, false);
+    retriever.SetUrl(QString("http://127.0.0.1:%1/Tulokset/Tulosarkisto").arg(server.port()));
+
+    int failed = 0;
+    QBENCHMARK {
+        bool finished = false;
+        QEventLoop loop;
+        const QMetaObject::Connection connection = connect(
+                    &retriever, &SkiDataRetriever::DataReady, &loop,
+                    [&finished, &failed, &loop](int progress, int total, int failures){
+            if(progress == 0 && total == 0){
+                finished = true;
+                failed = failures;
+                loop.quit();
+            }
+        });
+        retriever.UpdateDataBase();
+        if(!finished)
+            loop.exec();
+        disconnect(connection);
+    }
+    QDir::setCurrent(current);
+
+    qInfo("%d requests, %d errors, %d dropped, %d years failed",
+          server.requests(), server.errors(), server.drops(), failed);
+    if(errorRate == 0 && dropRate == 0)
+        QCOMPARE(failed, 0);
+}
+
+void SkiBenchmark::getSkiingData_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::getSkiingData()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    int races = 0;
+    QBENCHMARK {
+        races = 0;
+        for(int year = data->firstYear; year <= data->lastYear; ++year)
+            races += data->retriever->GetSkiingData(year).size();
+    }
+    QVERIFY(races > 0);
+}
+
+void SkiBenchmark::searchRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::searchRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QVector<QString> params = QVector<QString>()
+            << QString::number(data->firstYear) << QString::number(data->lastYear)
+            << "All types" << "" << "" << "Female" << "" << "" << "" << "All"
+            << "0" << "All";
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &params](){
+            analyzer->handleSearchRequest(params);
+        });
+    }
+}
+
+void SkiBenchmark::compareRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::compareRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QVector<QString> params = QVector<QString>()
+            << BenchmarkRace << QString::number(data->firstYear)
+            << BenchmarkRace << QString::number(data->lastYear);
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &params](){
+            analyzer->handleCompareRequest(params);
+        });
+    }
+}
+
+void SkiBenchmark::timesRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::timesRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QVector<QString> params = QVector<QString>()
+            << QString::number(data->firstYear) << QString::number(data->lastYear)
+            << data->firstName << data->lastName;
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &params](){
+            analyzer->handleTimesRequest(params);
+        });
+    }
+}
+
+void SkiBenchmark::bestAthleteRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::bestAthleteRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QVector<QString> params = QVector<QString>()
+            << QString::number(data->firstYear) << QString::number(data->lastYear)
+            << "Male";
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &params](){
+            analyzer->handleBestAthleteRequest(params);
+        });
+    }
+}
+
+void SkiBenchmark::countriesRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::countriesRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QString param = QString("%1-%2").arg(data->firstYear).arg(data->lastYear);
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &param](){
+            analyzer->handleCountriesRequest(param);
+        });
+    }
+}
+
+void SkiBenchmark::teamsRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::teamsRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    const QVector<QString> params = QVector<QString>()
+            << QString::number(data->lastYear) << BenchmarkRace << "10" << "4";
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer, &params](){
+            analyzer->handleTeamsRequest(params);
+        });
+    }
+}
+
+void SkiBenchmark::predictionRequest_data()
+{
+    addDatasets();
+}
+
+void SkiBenchmark::predictionRequest()
+{
+    Fixture *data = fixture();
+    QVERIFY(data);
+
+    SkiAnalyzer *analyzer = data->analyzer.data();
+    QBENCHMARK {
+        runRequest(analyzer, [analyzer](){
+            analyzer->handlePredictionRequest(BenchmarkRace);
+        });
+    }
+}
+
+void SkiBenchmark::addDatasets()
+{
+    QTest::addColumn<QString>("dataset");
+    QTest::newRow("small") << QString("small");
+    QTest::newRow("medium") << QString("medium");
+    QTest::newRow("full") << QString("full");
+}
+
+QJsonObject SkiBenchmark::subset(const QString &dataset) const
+{
+    const int lastYear = m_years.last();
+    int firstYear = m_years.first();
+    if(dataset == "small")
+        firstYear = lastYear;
+    else if(dataset == "medium")
+        firstYear = qMax(firstYear, lastYear - MediumYears + 1);
+
+    QJsonObject data;
+    data.insert("anonymous", m_anonymous);
+    for(int year : m_years){
+        if(year >= firstYear && year <= lastYear)
+            data.insert(QString::number(year), m_source.value(QString::number(year)));
+    }
+    return data;
+}
+
+SkiBenchmark::Fixture *SkiBenchmark::fixture()
+{
+    const QString dataset = QTest::currentDataTag();
+    if(m_fixtures.contains(dataset))
+        return m_fixtures.value(dataset).data();
+
+    QSharedPointer<Fixture> data(new Fixture);
+    if(!data->dir.isValid())
+        return nullptr;
+
+    const QString filename = data->dir.filePath("import.json");
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly))
+        return nullptr;
+    file.write(QJsonDocument(subset(dataset)).toJson(QJsonDocument::Compact));
+    file.close();
+
+    // The retriever writes the database file that the analyzer reads in the
+    // same working directory
+    const QString current = QDir::currentPath();
+    QDir::setCurrent(data->dir.path());
+    data->retriever.reset(new SkiDataRetriever(nullptr, m_anonymous));
+    bool loaded = data->retriever->ImportData(filename);
+    if(loaded){
+        data->analyzer.reset(new SkiAnalyzer(nullptr, m_anonymous));
+        QSignalSpy ready(data->analyzer.data(), &SkiAnalyzer::dataReady);
+        data->analyzer->run();
+        loaded = !ready.isEmpty() && ready.last().at(0).toInt() == 0
+                && ready.last().at(1).toInt() == 0;
+    }
+    QDir::setCurrent(current);
+    if(!loaded)
+        return nullptr;
+
+    // Every request is analysed. Cached results would only measure the cache.
+    data->analyzer->setQueryCacheBudget(0);
+
+    const SkiResultStore &store = data->retriever->Store();
+    const QVector<int> years = store.years();
+    data->firstYear = years.first();
+    data->lastYear = years.last();
+
+    // The times are requested for the first athlete of the last year
+    const QVector<QString> name = SkiResultIndex::splitName(
+                store.year(data->lastYear).text(SkiResultStore::Name, 0));
+    data->lastName = name.value(0);
+    data->firstName = name.value(1);
+
+    m_fixtures.insert(dataset, data);
+    return data.data();
+}
+
+void SkiBenchmark::runRequest(SkiAnalyzer *analyzer, const std::function<void()> &request)
+{
+    // Searches continue in the event loop, the other requests are handled
+    // before the slot returns
+    bool finished = false;
+    QEventLoop loop;
+    const QMetaObject::Connection connection =
+            connect(analyzer, &SkiAnalyzer::dataSent, &loop, [&finished, &loop](){
+        finished = true;
+        loop.quit();
+    });
+    request();
+    if(!finished)
+        loop.exec();
+    disconnect(connection);
+}
+
+QTEST_GUILESS_MAIN(SkiBenchmark)
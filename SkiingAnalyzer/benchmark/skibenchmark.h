@@ -0,0 +1,119 @@
+#ifndef SKIBENCHMARK_H
+#define SKIBENCHMARK_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QMap>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+
+#include <functional>
+
+#include "skianalyzer.h"
+#include "skidataretriever.h"
+
+/**
+ * @brief The SkiBenchmark class measures the retrieval, the parsing and
+ *        every analysis of SkiingAnalyzer. The results are read from the
+ *        JSON file named by SKI_BENCHMARK_DATA, written by ExportData or by
+ *        older versions of the software. Result pages are read from the
+ *        directory named by SKI_BENCHMARK_PAGES. Results and pages are
+ *        generated by SkiResultGenerator if the variables aren't set. Each
+ *        benchmark is run on a small, a medium and a full dataset made of the
+ *        last year, the last ten years and all of the years of the results.
+ *        Full retrievals are measured against SkiStandInServer with and
+ *        without slow and failing responses.
+ */
+class SkiBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SkiBenchmark(QObject *parent = nullptr);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void importJson_data();
+    void importJson();
+
+    void parsePage_data();
+    void parsePage();
+
+    void refresh_data();
+    void refresh();
+
+    void getSkiingData_data();
+    void getSkiingData();
+
+    void searchRequest_data();
+    void searchRequest();
+
+    void compareRequest_data();
+    void compareRequest();
+
+    void timesRequest_data();
+    void timesRequest();
+
+    void bestAthleteRequest_data();
+    void bestAthleteRequest();
+
+    void countriesRequest_data();
+    void countriesRequest();
+
+    void teamsRequest_data();
+    void teamsRequest();
+
+    void predictionRequest_data();
+    void predictionRequest();
+
+private:
+    /**
+     * @brief The Fixture struct holds a dataset loaded to a retriever and an
+     *        analyzer, and the parameters the requests are made with.
+     */
+    struct Fixture {
+        QTemporaryDir                    dir;
+        QScopedPointer<SkiDataRetriever> retriever;
+        QScopedPointer<SkiAnalyzer>      analyzer;
+        int                              firstYear;
+        int                              lastYear;
+        QString                          firstName;
+        QString                          lastName;
+    };
+
+    /**
+     * @brief addDatasets: Adds the datasets as the rows of a benchmark
+     */
+    void addDatasets();
+
+    /**
+     * @brief subset: Returns the years of the source file in a range
+     * @param dataset: Name of the dataset
+     * @return JSON database of the years of the dataset
+     */
+    QJsonObject subset(const QString &dataset) const;
+
+    /**
+     * @brief fixture: Returns the loaded dataset of the current row. The
+     *        dataset is loaded on the first call.
+     * @return Fixture, or nullptr if the dataset couldn't be loaded
+     */
+    Fixture *fixture();
+
+    /**
+     * @brief runRequest: Makes a request to an analyzer and waits until it
+     *        has been handled
+     * @param analyzer: Analyzer the request is made to
+     * @param request: Function that calls a handle*Request slot
+     */
+    void runRequest(SkiAnalyzer *analyzer, const std::function<void()> &request);
+
+    QJsonObject                            m_source;
+    QVector<int>                           m_years;
+    bool                                   m_anonymous;
+    QMap<QString, QSharedPointer<Fixture>> m_fixtures;
+};
+
+#endif // SKIBENCHMARK_H
@@ -0,0 +1,290 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QTextStream>
+
+#include <algorithm>
+
+#include "skiengine.h"
+
+namespace {
+
+typedef QVector<QVector<QString>> Rows;
+
+/**
+ * @brief csvField: Quotes a field for CSV if it needs to be
+ * @param field: Text of the field
+ * @return Field as written to a CSV file
+ */
+QString csvField(const QString &field)
+{
+    if(!field.contains(',') && !field.contains('"') && !field.contains('\n'))
+        return field;
+
+    QString quoted = field;
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+/**
+ * @brief jsonRows: Converts rows of cells to a JSON array of arrays
+ * @param rows: Rows of the answer
+ * @return Array of the rows
+ */
+QJsonArray jsonRows(const Rows &rows)
+{
+    QJsonArray array;
+    for(const QVector<QString> &row : rows){
+        QJsonArray cells;
+        for(const QString &cell : row)
+            cells.append(cell);
+        array.append(cells);
+    }
+    return array;
+}
+
+/**
+ * @brief writeRows: Writes rows of cells in the chosen format
+ * @param out: Stream to write to
+ * @param rows: Rows of the answer
+ * @param format: "text", "csv" or "json"
+ */
+void writeRows(QTextStream &out, const Rows &rows, const QString &format)
+{
+    if(format == "json"){
+        out << QJsonDocument(jsonRows(rows)).toJson(QJsonDocument::Indented);
+        return;
+    }
+
+    for(const QVector<QString> &row : rows){
+        QStringList cells;
+        for(const QString &cell : row)
+            cells << (format == "csv" ? csvField(cell) : cell);
+        out << cells.join(format == "csv" ? "," : "\t") << "\n";
+    }
+}
+
+/**
+ * @brief searchRows: Formats the blocks of a search to rows
+ * @param results: Blocks of search results
+ * @return Rows in the columns of the result view
+ */
+Rows searchRows(const QVector<SkiResultSetPtr> &results)
+{
+    Rows rows;
+    for(const SkiResultSetPtr &block : results){
+        for(int i = 0; i < block->size(); ++i){
+            QVector<QString> row;
+            for(int column = 0; column < SkiResultSet::ColumnCount; ++column)
+                row << block->text(i, column);
+            rows << row;
+        }
+    }
+    return rows;
+}
+
+/**
+ * @brief timesRows: Splits the answer of a times query to rows
+ * @param times: Year, distance and time in hours of every result
+ * @return One row for each result
+ */
+Rows timesRows(const QVector<QString> &times)
+{
+    const int columns = 3;
+    Rows rows;
+    for(int i = 0; i + columns <= times.size(); i += columns)
+        rows << times.mid(i, columns);
+    return rows;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("SkiingCli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Runs the analyses of SkiingAnalyzer without a user interface.\n\n"
+                "Queries:\n"
+                "  search FROM TO                    Search results, see the search options\n"
+                "  compare TYPE1 YEAR1 TYPE2 YEAR2   Compare two races\n"
+                "  times FROM TO FIRSTNAME LASTNAME  Times of an athlete\n"
+                "  best FROM TO GENDER               Best athletes of every race\n"
+                "  countries YEAR|FROM-TO            Participants by nationality\n"
+                "  teams YEAR TYPE [COUNT [SIZE]]    Top teams of a race\n"
+                "  prediction TYPE                   Predicted winner of a race\n\n"
+                "Types and genders are given as in the user interface, e.g. "
+                "\"50 km traditional\" and \"Female\".");
+    parser.addHelpOption();
+    parser.addPositionalArgument("query", "Query to run, none to only load the data.");
+    parser.addPositionalArgument("params", "Parameters of the query.", "[params...]");
+
+    const QCommandLineOption dataDir("data-dir", "Directory of the database files.",
+                                     "directory", QDir::currentPath());
+    const QCommandLineOption anonymous("anonymous", "Keep anonymized results only.");
+    const QCommandLineOption importJson("import", "Replace the database with a JSON file.",
+                                        "file");
+    const QCommandLineOption refresh("refresh", "Retrieve the latest years first.");
+    const QCommandLineOption exportJson("export", "Write the database to a JSON file.",
+                                        "file");
+    const QCommandLineOption sequential("sequential", "Scan the years in one thread.");
+    const QCommandLineOption format("format", "Output format: text, csv or json.",
+                                    "format", "text");
+    const QCommandLineOption output("output", "Write the answer to a file.", "file");
+    const QCommandLineOption timing("timing", "Print the time taken to standard error.");
+    const QCommandLineOption type("type", "Search: competition type.", "type", "All types");
+    const QCommandLineOption firstName("first-name", "Search: first name.", "name");
+    const QCommandLineOption lastName("last-name", "Search: last name.", "name");
+    const QCommandLineOption gender("gender", "Search: Both, Male or Female.", "gender", "Both");
+    const QCommandLineOption team("team", "Search: team.", "team");
+    const QCommandLineOption nationality("nationality", "Search: nationality.", "code");
+    const QCommandLineOption locality("locality", "Search: locality.", "locality");
+    const QCommandLineOption top("top", "Search: placements shown from each race.", "count",
+                                 "All");
+    const QCommandLineOption fromTime("from-time", "Search: shortest time in hours.", "hours",
+                                      "0");
+    const QCommandLineOption toTime("to-time", "Search: longest time in hours.", "hours",
+                                    "All");
+    parser.addOptions({dataDir, anonymous, importJson, refresh, exportJson, sequential,
+                       format, output, timing, type, firstName, lastName, gender, team,
+                       nationality, locality, top, fromTime, toTime});
+    parser.process(a);
+
+    QTextStream err(stderr);
+    const QStringList args = parser.positionalArguments();
+    const QString query = args.value(0);
+    const QVector<QString> params = args.mid(1).toVector();
+    const QString outputFormat = parser.value(format);
+    if(outputFormat != "text" && outputFormat != "csv" && outputFormat != "json"){
+        err << "Unknown format " << outputFormat << "\n";
+        return 1;
+    }
+
+    // The database files are read from and written to the working directory
+    const QString startDir = QDir::currentPath();
+    const auto absolute = [&startDir](const QString &filename){
+        return QDir(startDir).absoluteFilePath(filename);
+    };
+    if(!QDir::setCurrent(parser.value(dataDir))){
+        err << "No directory " << parser.value(dataDir) << "\n";
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    SkiEngine engine(parser.isSet(anonymous));
+    engine.setParallel(!parser.isSet(sequential));
+    if(parser.isSet(importJson) && !engine.importJson(absolute(parser.value(importJson)))){
+        err << "Couldn't import " << parser.value(importJson) << "\n";
+        return 1;
+    }
+    if(!engine.open())
+        err << "Some years couldn't be retrieved\n";
+    if(parser.isSet(timing))
+        err << "open: " << timer.elapsed() << " ms, " << engine.store().size() << " results\n";
+
+    if(parser.isSet(refresh) && !engine.refresh())
+        err << "Some years couldn't be refreshed or saved\n";
+    if(parser.isSet(exportJson) && !engine.exportJson(absolute(parser.value(exportJson)))){
+        err << "Couldn't export " << parser.value(exportJson) << "\n";
+        return 1;
+    }
+    if(query.isEmpty())
+        return 0;
+
+    const QMap<QString, int> paramCounts = {
+        {"search", 2}, {"compare", 4}, {"times", 4}, {"best", 3},
+        {"countries", 1}, {"teams", 2}, {"prediction", 1}
+    };
+    if(!paramCounts.contains(query)){
+        err << "Unknown query " << query << "\n";
+        return 1;
+    }
+    if(params.size() < paramCounts.value(query)){
+        err << query << " needs " << paramCounts.value(query) << " parameters\n";
+        return 1;
+    }
+
+    QFile file;
+    if(parser.isSet(output)){
+        file.setFileName(absolute(parser.value(output)));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+            err << "Couldn't write " << parser.value(output) << "\n";
+            return 1;
+        }
+    }
+    else{
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+
+    timer.restart();
+    if(query == "search"){
+        const QVector<QString> searchParams = QVector<QString>()
+                << params[0] << params[1] << parser.value(type)
+                << parser.value(firstName) << parser.value(lastName)
+                << parser.value(gender) << parser.value(team)
+                << parser.value(nationality) << parser.value(locality)
+                << parser.value(top) << parser.value(fromTime) << parser.value(toTime);
+        writeRows(out, searchRows(engine.search(searchParams)), outputFormat);
+    }
+    else if(query == "compare"){
+        const SkiEngine::Comparison comparison = engine.compare(params);
+        if(outputFormat == "json"){
+            QJsonObject object;
+            object.insert("first", jsonRows(comparison.first));
+            object.insert("second", jsonRows(comparison.second));
+            object.insert("participants", QJsonArray() << comparison.participants.first
+                                                       << comparison.participants.second);
+            out << QJsonDocument(object).toJson(QJsonDocument::Indented);
+        }
+        else{
+            Rows rows;
+            const int count = qMax(comparison.first.size(), comparison.second.size());
+            for(int i = 0; i < count; ++i)
+                rows << comparison.first.value(i) + comparison.second.value(i);
+            rows << (QVector<QString>() << comparison.participants.first
+                                        << comparison.participants.second);
+            writeRows(out, rows, outputFormat);
+        }
+    }
+    else if(query == "times"){
+        writeRows(out, timesRows(engine.times(params)), outputFormat);
+    }
+    else if(query == "best"){
+        writeRows(out, engine.bestAthletes(params), outputFormat);
+    }
+    else if(query == "countries"){
+        const QHash<QString, int> counts = engine.nationalities(params[0]);
+        QStringList nationalities = counts.keys();
+        std::sort(nationalities.begin(), nationalities.end(),
+                  [&counts](const QString &a, const QString &b){
+            return counts.value(a) != counts.value(b) ? counts.value(a) > counts.value(b)
+                                                      : a < b;
+        });
+        Rows rows;
+        for(const QString &nationality : nationalities)
+            rows << (QVector<QString>() << nationality << QString::number(counts.value(nationality)));
+        writeRows(out, rows, outputFormat);
+    }
+    else if(query == "teams"){
+        writeRows(out, engine.teams(params), outputFormat);
+    }
+    else if(query == "prediction"){
+        writeRows(out, Rows() << engine.prediction(params[0]), outputFormat);
+    }
+    out.flush();
+
+    if(parser.isSet(timing))
+        err << query << ": " << timer.elapsed() << " ms\n";
+    return 0;
+}
@@ -0,0 +1,52 @@
+QT       -= gui
+
+TARGET = SkiingEngine
+TEMPLATE = lib
+
+CONFIG += c++11 staticlib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../skiengine.pri)
+
+ski_trace: SOURCES += ../skitrace.cpp
+
+SOURCES += \
+    ../skianalyzer.cpp \
+    ../skidataretriever.cpp \
+    ../skiresultstore.cpp \
+    ../skisnapshot.cpp \
+    ../skistringdictionary.cpp \
+    ../skirequestscheduler.cpp \
+    ../skiresultpageparser.cpp \
+    ../skipageparsejob.cpp \
+    ../skisearchfilter.cpp \
+    ../skiresultset.cpp \
+    ../skiresultindex.cpp \
+    ../skicareerindex.cpp \
+    ../skiquerycache.cpp \
+    ../skisearchtask.cpp \
+    ../skiaggregator.cpp \
+    ../skiengine.cpp
+
+HEADERS += \
+    ../skianalyzer.h \
+    ../skidataretriever.h \
+    ../skiresultstore.h \
+    ../skicolumn.h \
+    ../skisnapshot.h \
+    ../skistringdictionary.h \
+    ../skirequestscheduler.h \
+    ../skiresultpageparser.h \
+    ../skipageparsejob.h \
+    ../skisearchfilter.h \
+    ../skiresultset.h \
+    ../skiresultindex.h \
+    ../skicareerindex.h \
+    ../skiquerycache.h \
+    ../skisearchtask.h \
+    ../skiyearscan.h \
+    ../skitopk.h \
+    ../skiaggregator.h \
+    ../skitrace.h \
+    ../skiengine.h
@@ -0,0 +1,30 @@
+QT       += core
+QT       -= gui
+
+TARGET = SkiingGenerator
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp \
+    skiresultgenerator.cpp
+
+HEADERS += \
+    skiresultgenerator.h
+
+# The result store is linked from the static engine library
+include(../skiengine.pri)
+
+win32:CONFIG(release, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/release
+else:win32:CONFIG(debug, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/debug
+else: ENGINE_DIR = $$OUT_PWD/../engine
+
+LIBS += -L$$ENGINE_DIR -lSkiingEngine
+
+win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
+else:win32:!win32-g++: PRE_TARGETDEPS += $$ENGINE_DIR/SkiingEngine.lib
+else: PRE_TARGETDEPS += $$ENGINE_DIR/libSkiingEngine.a
@@ -0,0 +1,76 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "skiresultgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("SkiingGenerator");
+
+    const SkiResultGenerator::Parameters defaults;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Generates synthetic skiing results as result pages and as a "
+                "JSON database readable by SkiingAnalyzer.");
+    parser.addHelpOption();
+
+    const QCommandLineOption firstYear("first-year", "First year.", "year",
+                                       QString::number(defaults.firstYear));
+    const QCommandLineOption lastYear("last-year", "Last year.", "year",
+                                      QString::number(defaults.lastYear));
+    const QCommandLineOption distances("distances", "Comma separated distance codes.",
+                                       "codes", defaults.distances.join(','));
+    const QCommandLineOption participants("participants", "Participants per race.",
+                                          "count", QString::number(defaults.participants));
+    const QCommandLineOption athletes("athletes", "Athletes the participants are drawn from.",
+                                      "count", QString::number(defaults.athletes));
+    const QCommandLineOption lastNames("last-names", "Different last names.",
+                                       "count", QString::number(defaults.lastNames));
+    const QCommandLineOption firstNames("first-names", "Different first names.",
+                                        "count", QString::number(defaults.firstNames));
+    const QCommandLineOption teams("teams", "Different teams.",
+                                   "count", QString::number(defaults.teams));
+    const QCommandLineOption localities("localities", "Different localities.",
+                                        "count", QString::number(defaults.localities));
+    const QCommandLineOption seed("seed", "Seed of the generated results.",
+                                  "seed", QString::number(defaults.seed));
+    const QCommandLineOption pages("pages", "Directory the result pages are written to.",
+                                   "directory");
+    const QCommandLineOption json("json", "File the JSON database is written to.",
+                                  "file");
+    parser.addOptions({firstYear, lastYear, distances, participants, athletes,
+                       lastNames, firstNames, teams, localities, seed, pages, json});
+    parser.process(a);
+
+    QTextStream err(stderr);
+    if(!parser.isSet(pages) && !parser.isSet(json)){
+        err << "Nothing to generate, give --pages or --json.\n";
+        return 1;
+    }
+
+    SkiResultGenerator::Parameters parameters;
+    parameters.firstYear = parser.value(firstYear).toInt();
+    parameters.lastYear = parser.value(lastYear).toInt();
+    parameters.distances = parser.value(distances).split(',', QString::SkipEmptyParts);
+    parameters.participants = parser.value(participants).toInt();
+    parameters.athletes = parser.value(athletes).toInt();
+    parameters.lastNames = parser.value(lastNames).toInt();
+    parameters.firstNames = parser.value(firstNames).toInt();
+    parameters.teams = parser.value(teams).toInt();
+    parameters.localities = parser.value(localities).toInt();
+    parameters.seed = parser.value(seed).toULongLong();
+    const SkiResultGenerator generator(parameters);
+
+    if(parser.isSet(pages) && !generator.writePages(parser.value(pages))){
+        err << "Couldn't write the pages to " << parser.value(pages) << "\n";
+        return 1;
+    }
+    if(parser.isSet(json) && !generator.writeJson(parser.value(json))){
+        err << "Couldn't write the JSON database to " << parser.value(json) << "\n";
+        return 1;
+    }
+    return 0;
+}
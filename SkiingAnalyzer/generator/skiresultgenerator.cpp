@@ -0,0 +1,394 @@
+#include "skiresultgenerator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace {
+
+// Syllables are a consonant and a vowel, so words of different syllables
+// are always different
+const char *const Syllables[] = {
+    "ka", "ke", "ki", "ko", "ku", "la", "le", "li", "lo", "lu", "ma", "me",
+    "mi", "mo", "na", "ne", "ni", "no", "pa", "pe", "pi", "po", "ra", "re",
+    "ri", "ro", "sa", "se", "si", "so", "ta", "te", "ti", "to", "va", "vi"
+};
+const int SyllableCount = sizeof(Syllables) / sizeof(Syllables[0]);
+
+const char *const ForeignNationalities[] = {
+    "SE", "NO", "EE", "RU", "DE", "FR", "IT", "US", "JP", "CH", "AT", "CZ"
+};
+const int ForeignNationalityCount =
+        sizeof(ForeignNationalities) / sizeof(ForeignNationalities[0]);
+
+// Shares of the athletes in percents
+const int MaleShare = 75;
+const int FinnishShare = 85;
+const int TeamShare = 40;
+const int NoTimeShare = 2;
+
+// Athletes are at least this old when they ski
+const int MinimumAge = 16;
+const int MaximumAge = 80;
+
+// Average pace of the classic and the free technique in centiseconds per km
+const int ClassicPace = 4 * 60 * 100 + 12 * 100;
+const int FreePace = 3 * 60 * 100 + 36 * 100;
+
+const QByteArray Empty = "&nbsp;";
+
+/**
+ * @brief The Random class is a small generator of pseudo-random numbers
+ *        that gives the same numbers on every platform, unlike the
+ *        distributions of the standard library.
+ */
+class Random
+{
+public:
+    explicit Random(quint64 seed) : m_state(seed) {}
+
+    quint64 next()
+    {
+        // SplitMix64
+        quint64 z = (m_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n)
+    {
+        return n <= 1 ? 0 : static_cast<int>(next() % static_cast<quint64>(n));
+    }
+
+    double uniform()
+    {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    quint64 m_state;
+};
+
+}
+
+SkiResultGenerator::Parameters::Parameters() :
+    firstYear(1974),
+    lastYear(2019),
+    distances(QStringList() << "P50" << "V50" << "P100" << "P32" << "V20"),
+    participants(1000),
+    athletes(20000),
+    lastNames(4000),
+    firstNames(600),
+    teams(500),
+    localities(300),
+    seed(1)
+{}
+
+SkiResultGenerator::SkiResultGenerator(const Parameters &parameters) :
+    m_parameters(parameters)
+{
+    m_parameters.participants = qMax(0, m_parameters.participants);
+    m_parameters.athletes = qMax(1, m_parameters.athletes);
+    m_parameters.lastNames = qMax(1, m_parameters.lastNames);
+    m_parameters.firstNames = qMax(1, m_parameters.firstNames);
+    m_parameters.teams = qMax(1, m_parameters.teams);
+    m_parameters.localities = qMax(1, m_parameters.localities);
+}
+
+const SkiResultGenerator::Parameters &SkiResultGenerator::parameters() const
+{
+    return m_parameters;
+}
+
+QVector<SkiResultStore::RawRecord> SkiResultGenerator::records(int year) const
+{
+    struct Entry {
+        Athlete athlete;
+        qint32  time;
+    };
+
+    // The archive has no results outside its years
+    QVector<SkiResultStore::RawRecord> records;
+    if(year < m_parameters.firstYear || year > m_parameters.lastYear)
+        return records;
+
+    records.reserve(m_parameters.distances.size() * m_parameters.participants);
+    const QByteArray yearText = QByteArray::number(year);
+
+    for(int d = 0; d < m_parameters.distances.size(); ++d){
+        const QByteArray distance = m_parameters.distances.at(d).toUtf8();
+        Random random(mix(m_parameters.seed ^ mix(static_cast<quint64>(year) * 64 + d)));
+
+        // Length of the race is the number in its code, e.g. 50 in "V50"
+        int km = 0;
+        for(const char c : distance){
+            if(c >= '0' && c <= '9')
+                km = km * 10 + (c - '0');
+            else if(km > 0)
+                break;
+        }
+        const int pace = distance.startsWith('V') ? FreePace : ClassicPace;
+
+        QVector<Entry> entries;
+        entries.reserve(m_parameters.participants);
+        for(int i = 0; i < m_parameters.participants; ++i){
+            // Athletes that are too young or too old this year are replaced
+            // by another draw. A few tries keep the generation bounded.
+            Entry entry;
+            for(int tries = 0; tries < 8; ++tries){
+                entry.athlete = athlete(random.below(m_parameters.athletes));
+                const int age = year - entry.athlete.birthYear;
+                if(age >= MinimumAge && age <= MaximumAge)
+                    break;
+            }
+
+            entry.time = SkiResultStore::NoTime;
+            if(random.below(100) >= NoTimeShare){
+                const double form = 0.95 + 0.1 * random.uniform();
+                entry.time = static_cast<qint32>(km * pace * entry.athlete.pace * form);
+            }
+            entries.append(entry);
+        }
+
+        // Results are listed by time and those without a time come last
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b){
+            if(a.time == SkiResultStore::NoTime || b.time == SkiResultStore::NoTime)
+                return b.time == SkiResultStore::NoTime && a.time != SkiResultStore::NoTime;
+            return a.time < b.time;
+        });
+
+        int placement = 0;
+        int male = 0;
+        int female = 0;
+        for(const Entry &entry : entries){
+            SkiResultStore::RawRecord record;
+            record.cells[SkiResultStore::Year] = yearText;
+            record.cells[SkiResultStore::Distance] = distance;
+            if(entry.time != SkiResultStore::NoTime){
+                record.cells[SkiResultStore::Time] = timeText(entry.time);
+                record.cells[SkiResultStore::Placement] = QByteArray::number(++placement);
+                if(entry.athlete.sex == "M")
+                    record.cells[SkiResultStore::PlacementMale] = QByteArray::number(++male);
+                else
+                    record.cells[SkiResultStore::PlacementFemale] = QByteArray::number(++female);
+            }
+            record.cells[SkiResultStore::Sex] = entry.athlete.sex;
+            record.cells[SkiResultStore::Name] = entry.athlete.name;
+            record.cells[SkiResultStore::Locality] = entry.athlete.locality;
+            record.cells[SkiResultStore::Nationality] = entry.athlete.nationality;
+            record.cells[SkiResultStore::BirthYear] = QByteArray::number(entry.athlete.birthYear);
+            record.cells[SkiResultStore::Team] = entry.athlete.team;
+            records.append(record);
+        }
+    }
+    return records;
+}
+
+QByteArray SkiResultGenerator::page(int year) const
+{
+    const QVector<SkiResultStore::RawRecord> rows = records(year);
+
+    QByteArray page = pageHeader(year);
+    page.reserve(page.size() + rows.size() * 400);
+    page += "<table class=\"rgMasterTable\" id=\"dnn_ctr1025_Etusivu_dgrTulokset_ctl00\">\n"
+            "<tbody>\n";
+
+    for(int row = 0; row < rows.size(); ++row){
+        page += row % 2 == 0 ? "<tr class=\"rgRow\"" : "<tr class=\"rgAltRow\"";
+        page += " id=\"dnn_ctr1025_Etusivu_dgrTulokset_ctl00__";
+        page += QByteArray::number(row);
+        page += "\">\n";
+        for(int field = 0; field < SkiResultStore::FieldCount; ++field){
+            const QByteArray &cell = rows.at(row).cells[field];
+            page += "\t<td>";
+            page += cell.isEmpty() ? Empty : cell;
+            page += "</td>\n";
+        }
+        page += "</tr>\n";
+    }
+
+    page += "</tbody>\n</table>\n</div>\n</form>\n</body>\n</html>\n";
+    return page;
+}
+
+QByteArray SkiResultGenerator::formPage() const
+{
+    return pageHeader(m_parameters.lastYear) + "</div>\n</form>\n</body>\n</html>\n";
+}
+
+QJsonObject SkiResultGenerator::json() const
+{
+    QJsonObject data;
+    data.insert("anonymous", false);
+
+    QString names[SkiResultStore::FieldCount];
+    for(int field = 0; field < SkiResultStore::FieldCount; ++field)
+        names[field] = SkiResultStore::fieldName(static_cast<SkiResultStore::Field>(field));
+
+    for(int year = m_parameters.firstYear; year <= m_parameters.lastYear; ++year){
+        QHash<QByteArray, QJsonArray> distances;
+        for(const SkiResultStore::RawRecord &record : records(year)){
+            QJsonObject info;
+            for(int field = 0; field < SkiResultStore::FieldCount; ++field)
+                info.insert(names[field], QString::fromUtf8(record.cells[field]));
+            distances[record.cells[SkiResultStore::Distance]].append(info);
+        }
+
+        QJsonObject skiers;
+        for(auto it = distances.constBegin(); it != distances.constEnd(); ++it)
+            skiers.insert(QString::fromUtf8(it.key()), it.value());
+        data.insert(QString::number(year), skiers);
+    }
+    return data;
+}
+
+bool SkiResultGenerator::writePages(const QString &path) const
+{
+    QDir dir(path);
+    if(!dir.mkpath(".")){
+        return false;
+    }
+
+    for(int year = m_parameters.firstYear; year <= m_parameters.lastYear; ++year){
+        QSaveFile file(dir.filePath(QString("%1.html").arg(year)));
+        if(!file.open(QIODevice::WriteOnly)){
+            return false;
+        }
+        file.write(page(year));
+        if(!file.commit()){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SkiResultGenerator::writeJson(const QString &filename) const
+{
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)){
+        return false;
+    }
+    file.write(QJsonDocument(json()).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+SkiResultGenerator::Athlete SkiResultGenerator::athlete(int index) const
+{
+    Random random(mix(m_parameters.seed ^ mix(~static_cast<quint64>(index))));
+
+    Athlete athlete;
+    athlete.name = word(random.below(m_parameters.lastNames), "nen") + ' '
+            + word(random.below(m_parameters.firstNames), "");
+    athlete.sex = random.below(100) < MaleShare ? "M" : "F";
+    athlete.locality = word(random.below(m_parameters.localities), "la");
+
+    if(random.below(100) < FinnishShare)
+        athlete.nationality = "FI";
+    else
+        athlete.nationality = ForeignNationalities[random.below(ForeignNationalityCount)];
+
+    const int team = random.below(m_parameters.teams);
+    if(random.below(100) < TeamShare)
+        athlete.team = word(team, " Hiihtoseura");
+
+    // Athletes are born so that they can ski on some of the years
+    const int firstBirthYear = m_parameters.firstYear - MaximumAge + MinimumAge;
+    const int lastBirthYear = m_parameters.lastYear - MinimumAge;
+    athlete.birthYear = firstBirthYear + random.below(lastBirthYear - firstBirthYear + 1);
+
+    // Paces are skewed towards the faster end, like in real races
+    const double skill = random.uniform();
+    athlete.pace = 0.7 + 0.8 * skill * skill;
+    return athlete;
+}
+
+QByteArray SkiResultGenerator::pageHeader(int year) const
+{
+    const quint64 state = mix(m_parameters.seed);
+
+    QByteArray page =
+            "<!DOCTYPE html>\n"
+            "<html lang=\"fi-FI\">\n"
+            "<head><meta charset=\"utf-8\" /><title>Tulosarkisto</title></head>\n"
+            "<body>\n"
+            "<form method=\"post\" action=\"/Tulokset/Tulosarkisto\" id=\"Form\">\n"
+            "<input type=\"hidden\" name=\"__VIEWSTATE\" id=\"__VIEWSTATE\" value=\"";
+    page += QByteArray::number(state, 16).toBase64();
+    page += "\" />\n"
+            "<input type=\"hidden\" name=\"__VIEWSTATEGENERATOR\" id=\"__VIEWSTATEGENERATOR\" value=\"CA0B0334\" />\n"
+            "<input type=\"hidden\" name=\"__EVENTVALIDATION\" id=\"__EVENTVALIDATION\" value=\"";
+    page += QByteArray::number(mix(state), 16).toBase64();
+    page += "\" />\n"
+            "<div id=\"dnn_ctr1025_Etusivu_pnlHaku\">\n"
+            "<select name=\"dnn$ctr1025$Etusivu$ddlVuosi2x\" id=\"dnn_ctr1025_Etusivu_ddlVuosi2x\">\n";
+
+    // A year outside the archive is still shown as selected on its page
+    if(year > m_parameters.lastYear || year < m_parameters.firstYear){
+        page += "\t<option selected=\"selected\" value=\"";
+        page += QByteArray::number(year);
+        page += "\">";
+        page += QByteArray::number(year);
+        page += "</option>\n";
+    }
+
+    for(int option = m_parameters.lastYear; option >= m_parameters.firstYear; --option){
+        page += option == year ? "\t<option selected=\"selected\" value=\"" : "\t<option value=\"";
+        page += QByteArray::number(option);
+        page += "\">";
+        page += QByteArray::number(option);
+        page += "</option>\n";
+    }
+
+    page += "</select>\n"
+            "<select name=\"dnn$ctr1025$Etusivu$ddlMatka2x\" id=\"dnn_ctr1025_Etusivu_ddlMatka2x\">\n"
+            "\t<option selected=\"selected\" value=\"kaikki\">kaikki</option>\n";
+    for(const QString &distance : m_parameters.distances){
+        page += "\t<option value=\"";
+        page += distance.toUtf8();
+        page += "\">";
+        page += distance.toUtf8();
+        page += "</option>\n";
+    }
+    page += "</select>\n"
+            "</div>\n"
+            "<div id=\"dnn_ctr1025_Etusivu_dgrTulokset\" class=\"RadGrid\">\n";
+    return page;
+}
+
+quint64 SkiResultGenerator::mix(quint64 value)
+{
+    return Random(value).next();
+}
+
+QByteArray SkiResultGenerator::word(int index, const QByteArray &suffix)
+{
+    // Index is written in base of the syllables with at least two digits
+    QByteArray text = Syllables[index % SyllableCount];
+    index /= SyllableCount;
+    do {
+        text += Syllables[index % SyllableCount];
+        index /= SyllableCount;
+    } while(index > 0);
+
+    text[0] = text.at(0) - 'a' + 'A';
+    return text + suffix;
+}
+
+QByteArray SkiResultGenerator::timeText(qint32 time)
+{
+    const int hours = time / (60 * 60 * 100);
+    const int minutes = time / (60 * 100) % 60;
+    const int seconds = time / 100 % 60;
+    const int hundredths = time % 100;
+
+    return QString("%1:%2:%3.%4").arg(hours)
+                                 .arg(minutes, 2, 10, QChar('0'))
+                                 .arg(seconds, 2, 10, QChar('0'))
+                                 .arg(hundredths, 2, 10, QChar('0')).toLatin1();
+}
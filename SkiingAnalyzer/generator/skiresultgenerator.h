@@ -0,0 +1,148 @@
+#ifndef SKIRESULTGENERATOR_H
+#define SKIRESULTGENERATOR_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiResultGenerator class generates synthetic skiing results in
+ *        the layout of the result pages of Finlandia hiihto and in the JSON
+ *        database format of SkiDataRetriever. The results depend only on the
+ *        parameters, so the same parameters always generate the same pages
+ *        on every platform. Every year is generated independently of the
+ *        other years, and the athletes are drawn from a common pool so that
+ *        they have results on several years.
+ */
+class SkiResultGenerator
+{
+public:
+    /**
+     * @brief The Parameters struct holds the size and the shape of the
+     *        generated archive.
+     */
+    struct Parameters {
+        int         firstYear;
+        int         lastYear;
+        QStringList distances;
+        int         participants;
+        int         athletes;
+        int         lastNames;
+        int         firstNames;
+        int         teams;
+        int         localities;
+        quint64     seed;
+
+        Parameters();
+    };
+
+    /**
+     * @brief SkiResultGenerator: Creates a generator
+     * @param parameters: Size and shape of the archive
+     */
+    explicit SkiResultGenerator(const Parameters &parameters = Parameters());
+
+    const Parameters &parameters() const;
+
+    /**
+     * @brief records: Generates the results of a year
+     * @param year: Year of the results
+     * @return Results of every distance in the order of the result page,
+     *         empty if the year is outside the archive
+     */
+    QVector<SkiResultStore::RawRecord> records(int year) const;
+
+    /**
+     * @brief page: Generates the result page of a year
+     * @param year: Year of the results
+     * @return Page as it is returned to the post request of the year
+     */
+    QByteArray page(int year) const;
+
+    /**
+     * @brief formPage: Generates the search page without results
+     * @return Page as it is returned to the get request
+     */
+    QByteArray formPage() const;
+
+    /**
+     * @brief json: Generates the JSON database of every year
+     * @return Database as written by SkiDataRetriever::ExportData
+     */
+    QJsonObject json() const;
+
+    /**
+     * @brief writePages: Writes the result page of every year to a directory
+     *        as <year>.html
+     * @param path: Directory of the pages, created if it doesn't exist
+     * @return Boolean indicating if writing was successful
+     */
+    bool writePages(const QString &path) const;
+
+    /**
+     * @brief writeJson: Writes the JSON database to a file
+     * @param filename: Filename of the JSON file
+     * @return Boolean indicating if writing was successful
+     */
+    bool writeJson(const QString &filename) const;
+
+private:
+    /**
+     * @brief The Athlete struct holds the properties of an athlete that stay
+     *        the same from year to year.
+     */
+    struct Athlete {
+        QByteArray name;
+        QByteArray sex;
+        QByteArray locality;
+        QByteArray nationality;
+        QByteArray team;
+        int        birthYear;
+        double     pace;
+    };
+
+    /**
+     * @brief athlete: Returns the properties of an athlete of the pool
+     * @param index: Index of the athlete in the pool
+     * @return Athlete
+     */
+    Athlete athlete(int index) const;
+
+    /**
+     * @brief pageHeader: Generates the beginning of a page up to the result
+     *        table
+     * @param year: Year selected on the page
+     * @return Beginning of the page
+     */
+    QByteArray pageHeader(int year) const;
+
+    /**
+     * @brief mix: Scrambles a value into a uniformly distributed one
+     * @param value: Value to scramble
+     * @return Scrambled value
+     */
+    static quint64 mix(quint64 value);
+
+    /**
+     * @brief word: Builds a name-like word from syllables
+     * @param index: Index of the word. Different indexes give different words.
+     * @param suffix: Text appended to the word
+     * @return Capitalized word
+     */
+    static QByteArray word(int index, const QByteArray &suffix);
+
+    /**
+     * @brief timeText: Formats a time of the time column as on the page
+     * @param time: Time in centiseconds
+     * @return Time as h:mm:ss.cc
+     */
+    static QByteArray timeText(qint32 time);
+
+    Parameters m_parameters;
+};
+
+#endif // SKIRESULTGENERATOR_H
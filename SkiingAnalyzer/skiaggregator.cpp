@@ -0,0 +1,197 @@
+#include "skiaggregator.h"
+#include "skiyearscan.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SkiAggregator::SkiAggregator(const SkiResultStore &store, Dimension dimension) :
+    m_store(store),
+    m_dimension(dimension),
+    m_field(field(dimension)),
+    m_percentile(90.0),
+    m_orderStatistics(false)
+{
+    // Every dictionary id is mapped to its group once. Only birth years are
+    // combined, the other dimensions have a group for every id.
+    const SkiStringDictionary &dictionary = m_store.dictionary(m_field);
+    m_groupOfId.resize(dictionary.size());
+
+    if(m_dimension == BirthDecade){
+        QHash<QString, int> groups;
+        for(int id = 0; id < dictionary.size(); ++id){
+            bool ok = false;
+            const int year = dictionary.text(id).toInt(&ok);
+            const QString key = ok ? QString("%1s").arg(year - year % 10) : QString();
+
+            int group = groups.value(key, -1);
+            if(group == -1){
+                group = m_groupKeys.size();
+                groups.insert(key, group);
+                m_groupKeys.append(key);
+            }
+            m_groupOfId[id] = group;
+        }
+    }
+    else{
+        for(int id = 0; id < dictionary.size(); ++id){
+            m_groupOfId[id] = id;
+            m_groupKeys.append(dictionary.text(id));
+        }
+    }
+}
+
+void SkiAggregator::setPercentile(double percentile)
+{
+    m_percentile = qBound(0.0, percentile, 100.0);
+}
+
+void SkiAggregator::setOrderStatistics(bool enabled)
+{
+    m_orderStatistics = enabled;
+}
+
+QVector<SkiAggregator::Group> SkiAggregator::run(int fromYear, int toYear,
+                                                 QThreadPool *pool) const
+{
+    // Years are scanned independently and merged in year order
+    const QVector<Partial> partials = SkiYearScan::map(pool, fromYear, toYear,
+                                                       [this](int year){
+        return scanYear(year);
+    });
+
+    Partial total = emptyPartial();
+    for(const Partial &partial : partials)
+        merge(total, partial);
+
+    // Groups are listed in the order they first appear in the store
+    QVector<int> found;
+    for(int g = 0; g < m_groupKeys.size(); ++g){
+        if(total.counts.at(g) > 0)
+            found.append(g);
+    }
+    std::sort(found.begin(), found.end(), [&total](int a, int b){
+        return total.firstRows.at(a) < total.firstRows.at(b);
+    });
+
+    QVector<Group> groups;
+    groups.reserve(found.size());
+    for(int g : found){
+        Group group;
+        group.key = m_groupKeys.at(g);
+        group.count = total.counts.at(g);
+        group.timedCount = total.timedCounts.at(g);
+        group.minTime = SkiResultStore::NoTime;
+        group.maxTime = SkiResultStore::NoTime;
+        group.meanTime = 0;
+        group.medianTime = SkiResultStore::NoTime;
+        group.percentileTime = SkiResultStore::NoTime;
+
+        if(group.timedCount > 0){
+            group.minTime = total.minTimes.at(g);
+            group.maxTime = total.maxTimes.at(g);
+            group.meanTime = static_cast<double>(total.timeSums.at(g)) / group.timedCount;
+            if(m_orderStatistics){
+                QVector<qint32> &times = total.times[g];
+                group.medianTime = orderStatistic(times, 50.0);
+                group.percentileTime = orderStatistic(times, m_percentile);
+            }
+        }
+        groups.append(group);
+    }
+    return groups;
+}
+
+SkiAggregator::Partial SkiAggregator::scanYear(int year) const
+{
+    Partial partial = emptyPartial();
+    const SkiResultView data = m_store.year(year);
+
+    for(int i = 0; i < data.size(); ++i){
+        const int row = data.row(i);
+        const int g = m_groupOfId.at(m_store.idAt(m_field, row));
+
+        if(partial.counts.at(g) == 0)
+            partial.firstRows[g] = row;
+        ++partial.counts[g];
+
+        const qint32 time = data.time(i);
+        if(time == SkiResultStore::NoTime)
+            continue;
+
+        ++partial.timedCounts[g];
+        partial.minTimes[g] = qMin(partial.minTimes.at(g), time);
+        partial.maxTimes[g] = qMax(partial.maxTimes.at(g), time);
+        partial.timeSums[g] += time;
+        if(m_orderStatistics)
+            partial.times[g].append(time);
+    }
+    return partial;
+}
+
+SkiAggregator::Partial SkiAggregator::emptyPartial() const
+{
+    const int groups = m_groupKeys.size();
+
+    Partial partial;
+    partial.counts.fill(0, groups);
+    partial.timedCounts.fill(0, groups);
+    partial.minTimes.fill(std::numeric_limits<qint32>::max(), groups);
+    partial.maxTimes.fill(std::numeric_limits<qint32>::min(), groups);
+    partial.timeSums.fill(0, groups);
+    partial.firstRows.fill(std::numeric_limits<int>::max(), groups);
+    if(m_orderStatistics)
+        partial.times.resize(groups);
+    return partial;
+}
+
+void SkiAggregator::merge(Partial &total, const Partial &partial) const
+{
+    for(int g = 0; g < total.counts.size(); ++g){
+        if(partial.counts.at(g) == 0)
+            continue;
+
+        total.counts[g] += partial.counts.at(g);
+        total.timedCounts[g] += partial.timedCounts.at(g);
+        total.minTimes[g] = qMin(total.minTimes.at(g), partial.minTimes.at(g));
+        total.maxTimes[g] = qMax(total.maxTimes.at(g), partial.maxTimes.at(g));
+        total.timeSums[g] += partial.timeSums.at(g);
+        total.firstRows[g] = qMin(total.firstRows.at(g), partial.firstRows.at(g));
+        if(m_orderStatistics)
+            total.times[g] += partial.times.at(g);
+    }
+}
+
+SkiResultStore::Field SkiAggregator::field(Dimension dimension)
+{
+    switch(dimension){
+    case Nationality:
+        return SkiResultStore::Nationality;
+    case Team:
+        return SkiResultStore::Team;
+    case Locality:
+        return SkiResultStore::Locality;
+    case BirthDecade:
+        return SkiResultStore::BirthYear;
+    case Distance:
+        return SkiResultStore::Distance;
+    case Sex:
+        return SkiResultStore::Sex;
+    }
+    return SkiResultStore::Nationality;
+}
+
+qint32 SkiAggregator::orderStatistic(QVector<qint32> &times, double percentile)
+{
+    if(times.isEmpty())
+        return SkiResultStore::NoTime;
+
+    // Nearest rank: the smallest time that at least the percentile of the
+    // times are less than or equal to
+    int rank = static_cast<int>(std::ceil(percentile / 100.0 * times.size()));
+    rank = qBound(1, rank, times.size());
+    std::nth_element(times.begin(), times.begin() + (rank - 1), times.end());
+    return times.at(rank - 1);
+}
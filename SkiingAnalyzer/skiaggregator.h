@@ -0,0 +1,141 @@
+#ifndef SKIAGGREGATOR_H
+#define SKIAGGREGATOR_H
+
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiAggregator class groups the results of a range of years by
+ *        one dimension and calculates the number of results and statistics
+ *        of their times for every group. Groups are numbered densely from
+ *        the dictionary ids of the grouped field, so the statistics are kept
+ *        in arrays indexed by the group instead of hash maps keyed by text.
+ */
+class SkiAggregator
+{
+public:
+    /**
+     * @brief The Dimension enum lists the dimensions results can be grouped
+     *        by.
+     */
+    enum Dimension {
+        Nationality = 0,
+        Team,
+        Locality,
+        BirthDecade,
+        Distance,
+        Sex
+    };
+
+    /**
+     * @brief The Group struct holds the statistics of one group. Times are
+     *        in centiseconds and calculated only from the results that have
+     *        a time. They are NoTime if no result of the group has a time.
+     */
+    struct Group {
+        QString key;
+        int     count;
+        int     timedCount;
+        qint32  minTime;
+        qint32  maxTime;
+        double  meanTime;
+        qint32  medianTime;
+        qint32  percentileTime;
+    };
+
+    /**
+     * @brief SkiAggregator: Creates an aggregation over a store
+     * @param store: Store whose results are grouped
+     * @param dimension: Dimension the results are grouped by
+     * @pre Store is not modified while the aggregator is used
+     */
+    SkiAggregator(const SkiResultStore &store, Dimension dimension);
+
+    /**
+     * @brief setPercentile: Sets the percentile calculated for each group
+     * @param percentile: Percentile between 0 and 100, 90 by default
+     */
+    void setPercentile(double percentile);
+
+    /**
+     * @brief setOrderStatistics: Tells if the median and the percentile are
+     *        calculated. They need the times of every group to be collected,
+     *        so they are not calculated by default.
+     * @param enabled: True to calculate the median and the percentile
+     */
+    void setOrderStatistics(bool enabled);
+
+    /**
+     * @brief run: Groups the results of a range of years
+     * @param fromYear: First year
+     * @param toYear: Last year
+     * @param pool: Thread pool to scan the years on, or nullptr to scan them
+     *        in the calling thread
+     * @return Groups that have at least one result, in the order of the
+     *         first result of each group in the store
+     */
+    QVector<Group> run(int fromYear, int toYear, QThreadPool *pool = nullptr) const;
+
+private:
+    /**
+     * @brief The Partial struct holds the statistics of every group over
+     *        some of the years.
+     */
+    struct Partial {
+        QVector<int>             counts;
+        QVector<int>             timedCounts;
+        QVector<qint32>          minTimes;
+        QVector<qint32>          maxTimes;
+        QVector<qint64>          timeSums;
+        QVector<int>             firstRows;
+        QVector<QVector<qint32>> times;
+    };
+
+    /**
+     * @brief scanYear: Calculates the statistics of the groups of one year
+     * @param year: Year to scan
+     * @return Statistics of the year
+     */
+    Partial scanYear(int year) const;
+
+    /**
+     * @brief emptyPartial: Returns statistics for every group with no results
+     * @return Empty statistics
+     */
+    Partial emptyPartial() const;
+
+    /**
+     * @brief merge: Adds the statistics of other years to a total
+     * @param total: Statistics to add to
+     * @param partial: Statistics of other years
+     */
+    void merge(Partial &total, const Partial &partial) const;
+
+    /**
+     * @brief field: Returns the field of the store a dimension is read from
+     * @param dimension: Dimension
+     * @return Text field
+     */
+    static SkiResultStore::Field field(Dimension dimension);
+
+    /**
+     * @brief orderStatistic: Finds the time at a percentile
+     * @param times: Times of a group, reordered by the search
+     * @param percentile: Percentile between 0 and 100
+     * @return Time by the nearest rank method
+     */
+    static qint32 orderStatistic(QVector<qint32> &times, double percentile);
+
+    const SkiResultStore &m_store;
+    Dimension             m_dimension;
+    SkiResultStore::Field m_field;
+    QVector<int>          m_groupOfId;
+    QVector<QString>      m_groupKeys;
+    double                m_percentile;
+    bool                  m_orderStatistics;
+};
+
+#endif // SKIAGGREGATOR_H
@@ -1,8 +1,34 @@
 #include "skianalyzer.h"
-#include <QtCharts>
-#include <QRegExp>
+#include "skisearchfilter.h"
+#include "skiresultset.h"
+#include "skiyearscan.h"
+#include "skitopk.h"
+#include "skiaggregator.h"
+#include "skitrace.h"
+#include <QStringList>
+#include <QVariant>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Results are sent to the view in blocks of at most this many rows
+const int RowBlockSize = 2000;
+
+// Team rankings show this many teams counting this many skiers of each
+// team unless the request tells otherwise
+const int DefaultTeamCount = 10;
+const int DefaultTeamSize = 4;
+
+// Winners of these years are used to predict the next winner
+const int PredictionFirstYear = 2014;
+const int PredictionLastYear = 2019;
 
-SkiAnalyzer::SkiAnalyzer(QObject *parent, bool anonymous) : QObject(parent), m_anonymous(anonymous)
+}
+
+SkiAnalyzer::SkiAnalyzer(QObject *parent, bool anonymous) :
+    QObject(parent), m_retriever(nullptr), m_pool(nullptr), m_anonymous(anonymous),
+    m_parallel(true), m_searchGeneration(0)
 {
 
 }
@@ -11,13 +37,25 @@ void SkiAnalyzer::run()
 {
     // Initialize the SkiDataRetriever and make necessary connects.
     m_retriever = new SkiDataRetriever(this, m_anonymous);
-    connect(this, &SkiAnalyzer::refreshDataStorages, m_retriever, &SkiDataRetriever::UpdateDataBase);
+    m_pool = new QThreadPool(this);
+    connect(this, &SkiAnalyzer::refreshDataStorages, m_retriever, &SkiDataRetriever::RefreshDataBase);
+    connect(this, &SkiAnalyzer::updateDataStorages, m_retriever, &SkiDataRetriever::UpdateDataBase);
     connect(m_retriever, &SkiDataRetriever::DataReady, this, &SkiAnalyzer::dataReady);
+    connect(m_retriever, &SkiDataRetriever::SaveFailed, this, &SkiAnalyzer::saveFailed);
+    connect(m_retriever, &SkiDataRetriever::YearsChanged, this, [this](const QVector<int> &years){
+        m_cache.invalidateYears(years);
+    });
+    connect(m_retriever, &SkiDataRetriever::StoreReplaced, this, [this](){
+        // cached search results hold a copy of the old store.
+        m_cache.invalidateType("search");
+    });
     m_retriever->StartSkiingDataRetrieval();
 }
 
 void SkiAnalyzer::handleSearchRequest(const QVector<QString> &searchParams)
 {
+    SKI_TRACE_SPAN("query", "search");
+
     QString fromyear = searchParams[0];
     QString toyear = searchParams[1];
     QString comptype = searchParams[2];
@@ -31,147 +69,157 @@ void SkiAnalyzer::handleSearchRequest(const QVector<QString> &searchParams)
     QString timefrom = searchParams[10];
     QString timeto = searchParams[11];
 
-    //converting search distance to usable format.
-    QString searchdistanceparam = rtrnSearchDistanceParameter(comptype);
-    // all available data from searched years/distances
-    for(int i = fromyear.toInt(); i <= toyear.toInt(); i++){
-        SkiingData data;
-        QVector<QVector<QString>> tempcont;
-        if(searchdistanceparam != "all"){
-            data = m_retriever->GetSkiingData(i, searchdistanceparam);
-            for(int j = 0; j < data[searchdistanceparam].count(); j++){
-                QVector<QString> temp = createEmit(data, j, searchdistanceparam);
-                tempcont << temp;
-            }
+    // a newer search replaces a search that is still running.
+    if(m_search){
+        SKI_TRACE_END("query", "search total", m_searchGeneration);
+        m_search.reset();
+        ++m_searchGeneration;
+        emit searchSuperseded();
+    }
+
+    // repeated searches are answered from the cache.
+    const QString cachekey = SkiQueryCache::key("search", searchParams);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        for(const SkiResultSetPtr &results : cached.value<QVector<SkiResultSetPtr>>()){
+            emit searchResults(results);
         }
+        finishRequest(1);
+        return;
+    }
 
-        else{
-            data = m_retriever->GetSkiingData(i);
-            foreach(const QString &key, data.keys()){
-                for(int j = 0; j < data[key].count(); j++){
-                    QVector<QString> temp = createEmit(data, j, key);
+    //converting search distance to usable format.
+    QString searchdistanceparam = rtrnSearchDistanceParameter(comptype);
 
-                    tempcont << temp;
-                }
-            }
+    // at most this many results are shown from each year.
+    int limit = std::numeric_limits<int>::max();
+    if(topplacements != "All"){
+        limit = topplacements.toInt();
+    }
+
+    // the search is run one year at a time, so the results of the searched
+    // years are shown while it runs.
+    m_search.reset(new SkiSearchTask(m_retriever->Store(), fromyear.toInt(), toyear.toInt(),
+                                     searchdistanceparam, limit, RowBlockSize));
+    m_search->setThreadPool(scanPool());
+    m_searchKey = cachekey;
+    ++m_searchGeneration;
+    SkiSearchFilter &filter = m_search->filter();
+
+    // names, team, nationality and locality are looked up from the index.
+    // only the rows found in every posting list are tested further.
+    const SkiResultIndex &index = m_retriever->Index();
+    QVector<SkiResultIndex::RowRange> found;
+    const QPair<SkiResultIndex::Key, QString> lookups[] = {
+        qMakePair(SkiResultIndex::FirstName, forename),
+        qMakePair(SkiResultIndex::LastName, familyname),
+        qMakePair(SkiResultIndex::Team, team),
+        qMakePair(SkiResultIndex::Nationality, nationality),
+        qMakePair(SkiResultIndex::Locality, locality)
+    };
+    for(const auto &lookup : lookups){
+        if(lookup.second != ""){
+            found.append(index.rows(lookup.first, lookup.second));
         }
-        // vector containing all data is filtered one search parameter at a time:
-        // searching with forename
-        if (forename != ""){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-                QVector<QString> names = splitName(tempcont[k][5]);
-                if(names[1].toLower() == forename.toLower()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
+    }
+    if(!found.isEmpty()){
+        // only the shortest posting list is copied, the others are read in
+        // place while they are intersected with it.
+        std::sort(found.begin(), found.end(),
+                  [](const SkiResultIndex::RowRange &a, const SkiResultIndex::RowRange &b){
+            return a.size < b.size;
+        });
+        QVector<int> candidates = found.first().toVector();
+        for(int i = 1; i < found.size(); ++i){
+            candidates = SkiResultIndex::intersect(SkiResultIndex::RowRange(candidates),
+                                                   found.at(i));
         }
+        m_search->setCandidates(candidates);
+    }
 
-        // searching with familyname
-        if (familyname != ""){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-                QVector<QString> names = splitName(tempcont[k][5]);
-                if(names[0].toLower() == familyname.toLower()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
+    // the rest of the search params are compiled once into a filter which
+    // tests the rows of every searched year in a single pass.
+    if(gender != "Both"){
+        QString gendercompareparam = "";
+        if (gender == "Male"){
+            gendercompareparam = "M";
         }
-
-        // searching with gender
-        if(gender != "Both"){
-            QString gendercompareparam = "";
-            if (gender == "Male"){
-                gendercompareparam = "M";
-            }
-            else if (gender == "Female"){
-                gendercompareparam = "F";
-            }
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-                if(tempcont[k][4] == gendercompareparam){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
+        else if (gender == "Female"){
+            gendercompareparam = "F";
         }
+        filter.requireValue(SkiResultStore::Sex, gendercompareparam);
+    }
 
-        // searching with team
-        if(team != ""){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-
-                if(tempcont[k][9].toLower() == team.toLower()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
+    // time limits are given in hours and compared to the centisecond times.
+    // athletes without a time are left out when a limit is used.
+    if(timefrom != "0" || timeto != "All"){
+        const qint32 centisecondsperhour = 60 * 60 * 100;
+        qint32 mintime = qRound(timefrom.toFloat() * centisecondsperhour);
+        qint32 maxtime = std::numeric_limits<qint32>::max();
+        if(timeto != "All"){
+            maxtime = qRound(timeto.toFloat() * centisecondsperhour);
         }
+        filter.requireTime(mintime, maxtime);
+    }
 
-        // searching using nationality
-        if(nationality != ""){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
+    filter.compile();
 
-                if(tempcont[k][7].toLower() == nationality.toLower()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
-        }
+    // the search is timed from the request until its last year has been
+    // sent.
+    SKI_TRACE_BEGIN("query", "search total", m_searchGeneration);
+    continueSearch(m_searchGeneration);
+}
 
-        // searching using locality
-        if(locality != ""){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
+void SkiAnalyzer::cancelSearch()
+{
+    if(!m_search){
+        return;
+    }
 
-                if(tempcont[k][6].toLower() == locality.toLower()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
-        }
+    // results of the searched years stay in the view, but an incomplete
+    // search is not cached.
+    SKI_TRACE_END("query", "search total", m_searchGeneration);
+    m_search.reset();
+    ++m_searchGeneration;
+    finishRequest(1);
+}
 
-        // filtering by timelimit(s), both are done separately
-        if(timefrom != "0"){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-                if(timeToInt(tempcont[k][2]) >= timefrom.toFloat()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
-        }
-        if(timeto != "All"){
-            QVector<QVector<QString>> checkvector;
-            for(int k = 0; k < tempcont.count(); k++){
-                if(timeToInt(tempcont[k][2]) <= timeto.toFloat()){
-                    checkvector << tempcont[k];
-                }
-            }
-            tempcont = checkvector;
-        }
+void SkiAnalyzer::continueSearch(quint64 generation)
+{
+    SKI_TRACE_SPAN("query", "search step");
 
-        if(topplacements == "All"){
-            for(int k = 0; k < tempcont.count(); k++){
-                emit addNewRow(tempcont[k]);
+    // the step of a cancelled or replaced search does nothing.
+    if(!m_search || generation != m_searchGeneration){
+        return;
+    }
 
-            }
-        }
-        else{
-            for(int k = 0; k < tempcont.count() && k < topplacements.toInt(); k++){
-                emit addNewRow(tempcont[k]);
-            }
-        }
+    // matching rows are sent as result sets which the view formats only
+    // when they are shown.
+    for(const SkiResultSetPtr &results : m_search->step()){
+        emit searchResults(results);
+    }
+    emit searchProgress(m_search->progress(), m_search->total());
 
+    if(m_search->isFinished()){
+        const QVector<SkiResultSetPtr> &blocks = m_search->results();
+        m_cache.insert(m_searchKey, QVariant::fromValue(blocks), SkiQueryCache::costOf(blocks),
+                       m_search->fromYear(), m_search->toYear());
+        SKI_TRACE_END("query", "search total", generation);
+        m_search.reset();
+        finishRequest(1);
+        return;
     }
-    emit dataSent(1);
+
+    // the next year is searched after the requests that have arrived in
+    // the meantime.
+    QMetaObject::invokeMethod(this, [this, generation](){
+        continueSearch(generation);
+    }, Qt::QueuedConnection);
 }
 
 void SkiAnalyzer::handleCompareRequest(const QVector<QString> &params)
 {
+    SKI_TRACE_SPAN("query", "compare");
 
     QString type1 = rtrnSearchDistanceParameter(params[0]);
     QString year1 = params[1];
@@ -183,316 +231,300 @@ void SkiAnalyzer::handleCompareRequest(const QVector<QString> &params)
 
     if(type1 != "All" && type2 != "All"){
 
-        SkiingData data1 = m_retriever->GetSkiingData(year1.toInt(), type1);
-
-        SkiingData data2 = m_retriever->GetSkiingData(year2.toInt(), type2);
-
-        QVector<QVector<QString>> cont1;
-        for(int i = 0; i < data1[type1].count(); i++){
-
-            QVector<QString> temp = createEmit(data1, i, type1);
-
-            cont1 << temp;
-        }
+        const SkiResultView data1 = m_retriever->Store().race(year1.toInt(), type1);
 
-        QVector<QVector<QString>> cont2;
-        for(int i = 0; i < data2[type2].count(); i++){
+        const SkiResultView data2 = m_retriever->Store().race(year2.toInt(), type2);
 
-            QVector<QString> temp = createEmit(data2, i, type2);
-
-            cont2 << temp;
-        }
-
-
-        for(int j = 0; j < cont1.count(); j++){
-            total1++;
-            emit compareData(cont1[j], 1);
-        }
-
-        for(int j = 0; j < cont2.count(); j++){
-            total2++;
-            emit compareData(cont2[j], 2);
+        // both races are sent to their views in blocks of rows.
+        const SkiResultView datas[2] = {data1, data2};
+        for(int view = 0; view < 2; view++){
+            QVector<QVector<QString>> cont;
+            for(int i = 0; i < datas[view].size(); i++){
+                cont << createEmit(datas[view], i);
+                if(cont.size() == RowBlockSize){
+                    emit compareData(cont, view + 1);
+                    cont.clear();
+                }
+            }
+            if(!cont.isEmpty()){
+                emit compareData(cont, view + 1);
+            }
         }
+        total1 = data1.size();
+        total2 = data2.size();
 
     }
 
     emit compareNumberOfParticipants(qMakePair(QString().number(total1), QString().number(total2)));
 
-    emit dataSent(2);
+    finishRequest(2);
 }
 
 void SkiAnalyzer::handleTimesRequest(const QVector<QString> &params)
 {
+    SKI_TRACE_SPAN("query", "times");
+
     QString fromyear = params[0];
     QString toyear = params[1];
     QString fname = params[2];
     QString lname = params[3];
 
+    const QString cachekey = SkiQueryCache::key("times", params);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        emit timesData(cached.value<QVector<QString>>());
+        finishRequest(3);
+        return;
+    }
+
     QVector<QString> times;
 
 
     if(fname.length() > 0 && lname.length() > 0){
-        for(int i = fromyear.toInt(); i <= toyear.toInt(); i++){
-            SkiingData data;
-            QVector<QVector<QString>> tempcont;
-            data = m_retriever->GetSkiingData(i);
-
-            foreach(const QString &key, data.keys()){
-                for(int j = 0; j < data[key].count(); j++){
-                    QVector<QString> temp = createEmit(data, j, key);
-
-                    tempcont << temp;
-                }
-            }
-
-            if (fname != ""){
-                QVector<QVector<QString>> checkvector;
-                for(int k = 0; k < tempcont.count(); k++){
-                    QVector<QString> names = splitName(tempcont[k][5]);
-                    if(names[1].toLower() == fname.toLower()){
-                        checkvector << tempcont[k];
-                    }
-                }
-                tempcont = checkvector;
-            }
-
-            if (lname != ""){
-                QVector<QVector<QString>> checkvector;
-                for(int k = 0; k < tempcont.count(); k++){
-                    QVector<QString> names = splitName(tempcont[k][5]);
-                    if(names[0].toLower() == lname.toLower()){
-                        checkvector << tempcont[k];
-                    }
-                }
-                tempcont = checkvector;
-            }
-
-            for(int k = 0; k < tempcont.count(); k++){
-                times << tempcont[k][0] << tempcont[k][1] << QString().number(timeToInt(tempcont[k][2]));
+        const SkiResultStore &store = m_retriever->Store();
+        const SkiCareerIndex &careers = m_retriever->Careers();
+
+        // athletes with the same name but a different birth year have their
+        // own careers. their results are merged back to chronological order.
+        QVector<int> rows;
+        for(int athlete : careers.athletes(lname, fname)){
+            rows += careers.results(store, athlete);
+        }
+        std::sort(rows.begin(), rows.end());
+
+        for(int row : rows){
+            const int year = store.yearAt(row);
+            if(year >= fromyear.toInt() && year <= toyear.toInt()){
+                times << store.text(SkiResultStore::Year, row)
+                      << store.text(SkiResultStore::Distance, row)
+                      << QString().number(timeToHours(store.timeAt(row)));
             }
         }
     }
+    m_cache.insert(cachekey, QVariant::fromValue(times), SkiQueryCache::costOf(times),
+                   fromyear.toInt(), toyear.toInt());
     emit timesData(times);
-    emit dataSent(3);
+    finishRequest(3);
 }
 
 void SkiAnalyzer::handleBestAthleteRequest(const QVector<QString> &params)
 {
+    SKI_TRACE_SPAN("query", "best athletes");
+
     QString searchyear = params[0];
     QString searchToYear = params[1];
     QString gender = params[2];
 
-    //Going through the database year by year and race by race.
-    //And emiting the best athlete based on which gender was chosen.
-    for(int year = searchyear.toInt(); year <= searchToYear.toInt() ; year++){
-        SkiingData data = m_retriever->GetSkiingData(year);
-        QList<QString> keys = data.uniqueKeys();
-        for(int key = 0; key < keys.count() ; key++){
-            for(int i = 0; i < data[keys[key]].count() ;i++){
-                if(gender == "Male"){
-                    if(data[keys[key]][i]["placement"] == "1" && data[keys[key]][i]["sex"] == "M"){
-                        QString year (data[keys[key]][i]["year"]);
-                        QString name (data[keys[key]][i]["name"]);
-                        QString nationality (data[keys[key]][i]["nationality"]);
-                        QString team (data[keys[key]][i]["team"]);
-                        QString time (data[keys[key]][i]["time"]);
-                        QString distance (data[keys[key]][i]["distance"]);
-                        QString placement (data[keys[key]][i]["placement"]);
-                        QString sex (data[keys[key]][i]["sex"]);
-                        QString hometown (data[keys[key]][i]["locality"]);
-                        QString birthyear (data[keys[key]][i]["birthYear"]);
-                        float race = keys[key].remove(QRegExp(R"([\D])")).toFloat() / timeToInt(time);
-                        QString kesk = QString::number(race);
-                        if (kesk.lastIndexOf(QChar('.'))){
-                            int pos = kesk.lastIndexOf(QChar('.'));
-                            kesk = kesk.left(pos+3);
-                        }
-                        QString avgtime = kesk;
-
-                        QVector<QString> temp = QVector<QString>() << year << distance << time
-                                                                   << placement << sex << name << hometown
-                                                                   << nationality << birthyear << team << avgtime;
-
-                        emit bestAthleteData(temp);
-                    }
+    const QString cachekey = SkiQueryCache::key("best", params);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        const QVector<QVector<QString>> rows = cached.value<QVector<QVector<QString>>>();
+        if(!rows.isEmpty()){
+            emit bestAthleteData(rows);
+        }
+        finishRequest(4);
+        return;
+    }
+
+    const SkiResultStore &store = m_retriever->Store();
+    const qint64 male = store.dictionary(SkiResultStore::Sex).find("M");
 
+    //Going through the database year by year and race by race.
+    //And emiting the best athletes based on which gender was chosen.
+    //Years are scanned in parallel and merged back in year order.
+    const QVector<QVector<QVector<QString>>> years = SkiYearScan::map(
+                scanPool(), searchyear.toInt(), searchToYear.toInt(), [&](int year){
+        QVector<QVector<QString>> found;
+        const SkiResultView data = store.year(year);
+        for(int i = 0; i < data.size() ;i++){
+            if(gender == "Male"){
+                if(data.placement(i) == 1 && data.sex(i) == male){
+                    found << SkiResultSet::formatRow(store, data.row(i));
+                }
+            }
+            else if(gender == "Female"){
+                if(data.placementFemale(i) == 1){
+                    found << SkiResultSet::formatRow(store, data.row(i));
                 }
-                else if(gender == "Female")
-                    if(data[keys[key]][i]["placementFemale"] == "1"){
-                        QString year (data[keys[key]][i]["year"]);
-                        QString name (data[keys[key]][i]["name"]);
-                        QString nationality (data[keys[key]][i]["nationality"]);
-                        QString team (data[keys[key]][i]["team"]);
-                        QString time (data[keys[key]][i]["time"]);
-                        QString distance (data[keys[key]][i]["distance"]);
-                        QString placement (data[keys[key]][i]["placement"]);
-                        QString sex (data[keys[key]][i]["sex"]);
-                        QString hometown (data[keys[key]][i]["locality"]);
-                        QString birthyear (data[keys[key]][i]["birthYear"]);
-                        float race = keys[key].remove(QRegExp(R"([\D])")).toFloat() / timeToInt(time);
-                        QString kesk = QString::number(race);
-                        if (kesk.lastIndexOf(QChar('.'))){
-                            int pos = kesk.lastIndexOf(QChar('.'));
-                            kesk = kesk.left(pos+3);
-                        }
-                        QString avgtime = kesk;
-
-                        QVector<QString> temp = QVector<QString>() << year << distance << time
-                                                                   << placement << sex << name << hometown
-                                                                   << nationality << birthyear << team << avgtime;
-                        emit bestAthleteData(temp);
-                    }
             }
         }
-    }
-    emit dataSent(4);
+        return found;
+    });
+    QVector<QVector<QString>> rows;
+    for(const QVector<QVector<QString>> &yearRows : years){
+        rows += yearRows;
+    }
+    m_cache.insert(cachekey, QVariant::fromValue(rows), SkiQueryCache::costOf(rows),
+                   searchyear.toInt(), searchToYear.toInt());
+    if(!rows.isEmpty()){
+        emit bestAthleteData(rows);
+    }
+    finishRequest(4);
 }
 
 void SkiAnalyzer::handleCountriesRequest(const QString &param)
 {
-    int searchyear = param.toInt();
+    SKI_TRACE_SPAN("query", "countries");
+
+    //Param is either a single year or a range of years "from-to"
+    const QStringList years = param.split('-');
+    int fromyear = years.first().toInt();
+    int toyear = years.size() > 1 ? years.last().toInt() : fromyear;
+    if(toyear < fromyear)
+        std::swap(fromyear, toyear);
+
+    const QString cachekey = SkiQueryCache::key("countries", QVector<QString>() << param);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        emit nationalityDistributionData(cached.value<QHash<QString, int>>());
+        finishRequest(5);
+        return;
+    }
 
     //List contains information of all participated countries and number of their participants
     QHash<QString, int> List;
-    SkiingData data = m_retriever->GetSkiingData(searchyear);
-    QList<QString> distance = data.uniqueKeys();
-
-    //Going through the chosen years data one race at a time and in it one skiier at a time
-    for(int race = 0; race < distance.count(); race++){
-        for(int x = 0; x < data[distance[race]].count(); x++){
-            if(List.contains(data[distance[race]][x]["nationality"])){
-                List.insert(data[distance[race]][x]["nationality"], (List.value(data[distance[race]][x]["nationality"])+1));
-            }
-            else{
-                List.insert(data[distance[race]][x]["nationality"], 1);
-            }
-        }
-
+    const SkiAggregator aggregator(m_retriever->Store(), SkiAggregator::Nationality);
+    for(const SkiAggregator::Group &group : aggregator.run(fromyear, toyear, scanPool())){
+        List.insert(group.key, group.count);
     }
+    m_cache.insert(cachekey, QVariant::fromValue(List), SkiQueryCache::costOf(List),
+                   fromyear, toyear);
     emit nationalityDistributionData(List);
-    emit dataSent(5);
+    finishRequest(5);
 }
 
 void SkiAnalyzer::handleTeamsRequest(const QVector<QString> &params)
 {
+    SKI_TRACE_SPAN("query", "teams");
+
     int searchyear = params[0].toInt();
     QString distance = params[1];
     QString race = rtrnSearchDistanceParameter(distance);
-    SkiingData data = m_retriever->GetSkiingData(searchyear);
 
-    //List containing every team in a race and a vector of the teams times
-    QHash<QString, QVector<QString>> List;
+    const QString cachekey = SkiQueryCache::key("teams", params);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        const QVector<QVector<QString>> rows = cached.value<QVector<QVector<QString>>>();
+        if(!rows.isEmpty()){
+            emit teamsData(rows);
+        }
+        finishRequest(6);
+        return;
+    }
+
+    // number of teams shown and number of skiers counted for each team.
+    const int teamcount = params.size() > 2 ? qMax(1, params[2].toInt()) : DefaultTeamCount;
+    const int teamsize = params.size() > 3 ? qMax(1, params[3].toInt()) : DefaultTeamSize;
+
+    const SkiResultView data = m_retriever->Store().race(searchyear, race);
+
+    //List containing every team in a race and the best times of the team.
+    //Teams are also numbered in the order they first appear in the results,
+    //which orders teams with equal times.
+    struct TeamTimes {
+        SkiTopK<qint32> best;
+        int             order;
+    };
+    QHash<quint32, TeamTimes> List;
 
     //Going through the chosen year and race skiier by skiier
-    for(int x = 0; x < data[race].count(); x++){
-        if(List.contains(data[race][x]["team"])){
-            List[(data[race][x]["team"])].push_back(data[race][x]["time"]);
-        }
-        else if(data[race][x]["team"] != ""){
-            QVector<QString> team;
-            team.push_back(data[race][x]["time"]);
-            List.insert(data[race][x]["team"], team);
+    for(int x = 0; x < data.size(); x++){
+        const quint32 teamId = data.team(x);
+        const qint32 time = data.time(x);
+        if(teamId != 0 && time != SkiResultStore::NoTime){
+            auto it = List.find(teamId);
+            if(it == List.end()){
+                TeamTimes times;
+                times.best = SkiTopK<qint32>(teamsize);
+                times.order = List.size();
+                it = List.insert(teamId, times);
+            }
+            it->best.push(time);
         }
     }
-    //top10 map has only teams that meet the requirements. Teams total time, team name.
-    //Sorted by time
-    QMap<QString, QString> top10;
-
-    //Going through all the of the races team data and parsing the data for top10.
-    for(const QVector<QString> &teams : List){
-        QString temptime;
-        int tempHours = 0;
-        int tempMin = 0;
-        int tempSec = 0;
-        int tempSadas = 0;
-        if(teams.size() >= 4){
-            for(int skiier = 0 ; skiier < 4 ; skiier++){
-                QString splitTime = teams.at(skiier);
-                QStringList timeList = splitTime.split(":");
-                tempHours = tempHours + timeList.at(0).toInt();
-                tempMin = tempMin + timeList.at(1).toInt();
-                if(timeList.at(2).contains(".")){
-                    QStringList seconds = timeList.at(2).split(".");
-                    tempSec = tempSec + seconds.at(0).toInt();
-                    tempSadas = tempSadas + seconds.at(1).toInt();
-                }
-                else{
-                    tempSec = tempSec + timeList.at(2).toInt();
-                }
 
+    //Summing the best times of every team that has enough skiers and keeping
+    //the teams with the smallest totals. Equal totals are in team order.
+    struct TeamTotal {
+        qint64  total;
+        int     order;
+        quint32 team;
+    };
+    auto faster = [](const TeamTotal &a, const TeamTotal &b){
+        return a.total < b.total || (a.total == b.total && a.order < b.order);
+    };
+    SkiTopK<TeamTotal, decltype(faster)> top(teamcount, faster);
+    for(auto it = List.constBegin(); it != List.constEnd(); ++it){
+        if(it->best.isFull()){
+            TeamTotal total;
+            total.total = 0;
+            for(qint32 time : it->best.values()){
+                total.total += time;
             }
-            tempSec = tempSec + (tempSadas / 100);
-            tempSadas = tempSadas % 100;
-            tempMin = tempMin + (tempSec / 60);
-            tempSec = tempSec % 60;
-            tempHours = tempHours + (tempMin / 60);
-            tempMin = tempMin % 60;
-
-            QString hours = QString::number(tempHours);
-            QString minutes = QString::number(tempMin);
-            QString seconds = QString::number(tempSec);
-            QString sadas = QString::number(tempSadas);
-
-            if(tempHours < 10){
-                hours = "0"+hours;
-            }
-            if(tempMin < 10){
-                minutes = "0"+minutes;
-            }
-            if(tempSec < 10){
-                seconds = "0"+seconds;
-            }
-            if(tempSadas < 10){
-                sadas = "0"+sadas;
-            }
-
-            temptime = hours + ":" + minutes + ":" + seconds + "." + sadas;
-            top10.insert(temptime, List.key(teams));
+            total.order = it->order;
+            total.team = it.key();
+            top.push(total);
         }
     }
-    QList<QString> keys = top10.uniqueKeys();
-    int counter = 0;
 
-    //Going through top10 map to get the top10 teams and emiting the data
-    for(const QString &key : keys){
-        counter++;
-        float avgtime = timeToInt(key) / 4;
-
-        QString time = floatToTimeString(avgtime);
-
-        QString counterstring = QString::number(counter);
-        QString team = top10[key];
-        QVector<QString> temp = QVector<QString>() << counterstring << team << params[0]
-                                                   << distance << key << time;
-        emit teamsData(temp);
-        if(counter == 10){
-            break;
+    //Going through the top teams and emiting the data. Teams with equal
+    //totals share the rank.
+    const SkiStringDictionary &teamNames = m_retriever->Store().dictionary(SkiResultStore::Team);
+    const QVector<TeamTotal> ranked = top.sorted();
+    QVector<QVector<QString>> rows;
+    int rank = 0;
+    for(int i = 0; i < ranked.size(); i++){
+        if(i == 0 || ranked[i].total != ranked[i - 1].total){
+            rank = i + 1;
         }
-    }
-    emit dataSent(6);
+        const qint32 total = static_cast<qint32>(ranked[i].total);
+        QVector<QString> temp = QVector<QString>() << QString::number(rank)
+                                                   << teamNames.text(ranked[i].team)
+                                                   << params[0] << distance
+                                                   << timeToString(total, true)
+                                                   << timeToString(total / teamsize);
+        rows << temp;
+    }
+    m_cache.insert(cachekey, QVariant::fromValue(rows), SkiQueryCache::costOf(rows),
+                   searchyear, searchyear);
+    if(!rows.isEmpty()){
+        emit teamsData(rows);
+    }
+    finishRequest(6);
 }
 
 void SkiAnalyzer::handlePredictionRequest(const QString &param)
 {
+    SKI_TRACE_SPAN("query", "prediction");
+
     QString race = rtrnSearchDistanceParameter(param);
 
+    const QString cachekey = SkiQueryCache::key("prediction", QVector<QString>() << param);
+    QVariant cached;
+    if(m_cache.find(cachekey, cached)){
+        emit predictionData(cached.value<QVector<QString>>());
+        finishRequest(7);
+        return;
+    }
+
     //List containing the winners of past years races. Name, number of wins.
     QHash<QString, int> winnerList;
 
-    QVector<QString> totalTime;
+    QVector<qint32> totalTime;
 
     //Going through the race data year by year and storing the winner to List.
     //If the winner had won before int just goes up by 1.
-    for(int year = 2014; year < 2020; year++){
-        SkiingData data = m_retriever->GetSkiingData(year);
-        if(data[race].size() > 0){
-            if(winnerList.contains(data[race][0]["name"])){
-                winnerList.insert(data[race][0]["name"], (winnerList.value(data[race][0]["name"])+1));
-                totalTime.push_back(data[race][0]["time"]);
+    for(int year = PredictionFirstYear; year <= PredictionLastYear; year++){
+        const SkiResultView data = m_retriever->Store().race(year, race);
+        if(data.size() > 0){
+            const QString winner = data.text(SkiResultStore::Name, 0);
+            if(winnerList.contains(winner)){
+                winnerList.insert(winner, (winnerList.value(winner)+1));
+                totalTime.push_back(data.time(0));
             }
-            if(!winnerList.contains(data[race][0]["name"])){
-                winnerList.insert(data[race][0]["name"], 1);
-                totalTime.push_back(data[race][0]["time"]);
+            if(!winnerList.contains(winner)){
+                winnerList.insert(winner, 1);
+                totalTime.push_back(data.time(0));
             }
         }
     }
@@ -509,17 +541,52 @@ void SkiAnalyzer::handlePredictionRequest(const QString &param)
             mostwins = key;
         }
     }
-    float magicTime = 0;
-    for(const QString &time : totalTime){
-        magicTime = magicTime + timeToInt(time);
+    qint64 magicTime = 0;
+    int timedWinners = 0;
+    for(qint32 time : totalTime){
+        if(time != SkiResultStore::NoTime){
+            magicTime = magicTime + time;
+            timedWinners++;
+        }
     }
 
-    magicTime = magicTime / totalTime.size();
+    if(timedWinners > 0){
+        magicTime = magicTime / timedWinners;
+    }
+
+    QString time = timeToString(static_cast<qint32>(magicTime));
+
+    const QVector<QString> prediction = QVector<QString>() << mostwins << param << time;
+    m_cache.insert(cachekey, QVariant::fromValue(prediction), SkiQueryCache::costOf(prediction),
+                   PredictionFirstYear, PredictionLastYear);
+    emit predictionData(prediction);
+    finishRequest(7);
+}
+
+void SkiAnalyzer::setParallel(bool parallel)
+{
+    m_parallel = parallel;
+}
+
+SkiDataRetriever *SkiAnalyzer::retriever() const
+{
+    return m_retriever;
+}
+
+void SkiAnalyzer::setQueryCacheBudget(int budget)
+{
+    m_cache.setBudget(qMax(0, budget));
+}
 
-    QString time = floatToTimeString(magicTime);
+QThreadPool *SkiAnalyzer::scanPool() const
+{
+    return m_parallel ? m_pool : nullptr;
+}
 
-    emit predictionData(QVector<QString>() << mostwins << param << time);
-    emit dataSent(7);
+void SkiAnalyzer::finishRequest(int index)
+{
+    emit queryCacheStatistics(m_cache.hits(), m_cache.misses());
+    emit dataSent(index);
 }
 
 QString SkiAnalyzer::rtrnSearchDistanceParameter(const QString distance)
@@ -608,114 +675,36 @@ QString SkiAnalyzer::rtrnSearchDistanceParameter(const QString distance)
     return QString("");
 }
 
-QString SkiAnalyzer::floatToTimeString(const float time){
-    int avghours = time / 1;
-    int avgmin = (time-avghours) * 60 * 60 / 60;
-    int avgsec = (time-avghours-(avgmin/60))*60;
-
-    QString tempavghours = QString::number(avghours);
-    QString tempavgminutes = QString::number(avgmin);
-    QString tempavgseconds = QString::number(avgsec);
-
-    if(avghours < 10){
-        tempavghours = "0"+tempavghours;
+QString SkiAnalyzer::timeToString(qint32 time, bool centiseconds){
+    if(time == SkiResultStore::NoTime){
+        time = 0;
     }
-    if(avgmin < 10){
-        tempavgminutes = "0"+tempavgminutes;
-    }
-    if(avgsec < 10){
-        tempavgseconds = "0"+tempavgseconds;
-    }
-
-    QString avgtimestring = tempavghours + ":" + tempavgminutes + ":" + tempavgseconds;
-
-    return avgtimestring;
-}
 
-float SkiAnalyzer::timeToInt (const QString time)
-{
-    float total;
-    if(time.length() < 4){
-        total = 0;
-        return total;
-    }
-
-    QStringList list;
-    list = time.split(":");
-    QString h, m, s;
-    float hi = 0;
-    float mi = 0;
-    float si = 0;
-
-    if(list.count() == 3){
-        h = list[0];
-        m = list[1];
-        s = list[2];
-    }
+    int hours = time / (60 * 60 * 100);
+    int minutes = time / (60 * 100) % 60;
+    int seconds = time / 100 % 60;
+    int hundredths = time % 100;
 
-    else{
-        m = list[0];
-        s = list[1];
+    QString timestring = QString("%1:%2:%3").arg(hours, 2, 10, QChar('0'))
+                                            .arg(minutes, 2, 10, QChar('0'))
+                                            .arg(seconds, 2, 10, QChar('0'));
+    if(centiseconds){
+        timestring += QString(".%1").arg(hundredths, 2, 10, QChar('0'));
     }
 
-    hi = h.toFloat();
-    mi = m.toFloat();
-    si = s.toFloat();
-    total = hi + mi/60 + si/(60*60);
-
-    return total;
-
+    return timestring;
 }
 
-QVector<QString> SkiAnalyzer::createEmit(QHash<QString, QVector<QHash<QString, QString>>> data, int index, QString parameter)
+float SkiAnalyzer::timeToHours(qint32 time)
 {
-
-    QString vuosi = (data[parameter][index]["year"]);
-    QString nimi = (data[parameter][index]["name"]);
-    QString kans = (data[parameter][index]["nationality"]);
-    QString joukkue = (data[parameter][index]["team"]);
-    QString aika = (data[parameter][index]["time"]);
-    QString tyyppi = (data[parameter][index]["distance"]);
-    QString sijoitus = (data[parameter][index]["placement"]);
-    QString spuoli = (data[parameter][index]["sex"]);
-    QString paikkakunta = (data[parameter][index]["locality"]);
-    QString syntymavuosi = (data[parameter][index]["birthYear"]);
-
-    float matka = tyyppi.remove(QRegExp(R"([\D])")).toFloat();
-    QString kesk;
-
-    if (aika != 0){
-        float keskinopeus = matka/timeToInt(aika);
-        kesk = QString::number(keskinopeus);
-
-        // rounding average speed to 2 decimals.
-        if (kesk.lastIndexOf(QChar('.'))){
-            int pos = kesk.lastIndexOf(QChar('.'));
-            kesk = kesk.left(pos+3);
-        }
-    }
-    else{
-        kesk = "not available";
+    if(time == SkiResultStore::NoTime){
+        return 0;
     }
 
-    QVector<QString> temp = QVector<QString>() << vuosi << parameter << aika
-                                               << sijoitus << spuoli << nimi << paikkakunta
-                                               << kans << syntymavuosi << joukkue << kesk;
-    return temp;
+    return time / (60.0f * 60.0f * 100.0f);
 }
 
-QVector<QString>SkiAnalyzer::splitName(QString name){
-    QStringList list;
-    list = name.split(" ");
-    QVector<QString> rtrn;
-
-    if(list.length() == 2){
-        rtrn << list[0];
-        rtrn << list[1];
-    }
-    // in case of incomplete data or typo:
-    else{
-        rtrn << list[0] << "";
-    }
-    return rtrn;
+QVector<QString> SkiAnalyzer::createEmit(const SkiResultView &data, int index)
+{
+    return SkiResultSet::formatRow(*data.store(), data.row(index));
 }
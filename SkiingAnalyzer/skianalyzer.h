@@ -2,8 +2,13 @@
 #define SKIANALYZER_H
 
 #include <QObject>
+#include <QScopedPointer>
+#include <QThreadPool>
 
 #include "skidataretriever.h"
+#include "skiresultset.h"
+#include "skiquerycache.h"
+#include "skisearchtask.h"
 
 
 /**
@@ -20,6 +25,12 @@ class SkiAnalyzer : public QObject
 public:
     explicit SkiAnalyzer(QObject *parent = nullptr, bool anonymous = false);
 
+    /**
+     * @brief retriever returns the retriever the data is analysed from.
+     * @return the retriever, or nullptr before run has been called.
+     */
+    SkiDataRetriever *retriever() const;
+
 public slots:
     /**
      * @brief run slot starts the new thread that includes this class and the
@@ -29,12 +40,38 @@ public slots:
 
     /**
      * @brief handleSearchRequest searches the database and filters out all unneeded entries.
+     *        The years are searched one at a time between other requests and
+     *        a new search replaces a search that is still running.
      * @param searchParams: the parameters the user has input.
      * @pre parameters are valid, data is accessible.
-     * @post the searched data has been emitted.
+     * @post the search has been started. results are emitted as years are
+     *       searched and dataSent(1) when the search is complete.
      */
     void handleSearchRequest(const QVector<QString> &searchParams);
 
+    /**
+     * @brief cancelSearch stops the running search. results of the years
+     *        searched so far are kept.
+     * @post dataSent(1) has been emitted if a search was running.
+     */
+    void cancelSearch();
+
+    /**
+     * @brief setParallel selects how multi-year analyses are run.
+     * @param parallel: true to scan the years on a thread pool, false to
+     *        scan them one after another in the analyzer thread. Results
+     *        are in year order either way.
+     */
+    void setParallel(bool parallel);
+
+    /**
+     * @brief setQueryCacheBudget sets how much memory the cached results may
+     *        use.
+     * @param budget: memory budget in bytes. 0 disables the cache.
+     * @post results that don't fit the new budget have been dropped.
+     */
+    void setQueryCacheBudget(int budget);
+
     /**
      * @brief handleCompareRequest seaches database twice and show the result side-by-side.
      * @param params: user input
@@ -61,17 +98,20 @@ public slots:
 
     /**
      * @brief Counts all participants by country
-     * @param searchyear
-     * @pre   param needs to be a number
+     * @param searchyear or a range of years as "from-to"
+     * @pre   param needs to be a number or two numbers separated by '-'
      * @post  Emits nationalityDistributionData
      */
     void handleCountriesRequest(const QString &param);
 
     /**
-     * @brief Goes through data for given year and race and analyzes the top 10 teams for that race.
-     *        Comparison is done by counting the 4 best times of all teams.
-     * @param Search year, race.
-     * @pre   params has to be a QVector with 2 parameters and params[0] has to be a number.
+     * @brief Goes through data for given year and race and analyzes the top teams for that race.
+     *        Comparison is done by summing the best times of the skiers of each team. Teams
+     *        with equal sums share the rank and are listed in the order they first appear
+     *        in the results.
+     * @param Search year, race and optionally the number of teams (10 by default) and the
+     *        number of skiers counted from each team (4 by default).
+     * @pre   params has to be a QVector with 2 to 4 parameters and params[0] has to be a number.
      * @post  Emits teamsData.
      */
     void handleTeamsRequest(const QVector<QString> &params);
@@ -87,17 +127,32 @@ public slots:
 signals:
 
     /**
-     * @brief addNewRow signal sends search result data to SkiView
-     * @param row: the row of new data to be shown.
+     * @brief searchResults signal sends a block of search results to SkiView
+     * @param results: the results to be shown.
      */
-    void addNewRow(QVector<QString> row);
+    void searchResults(SkiResultSetPtr results);
 
     /**
-     * @brief compareData sends compare result data to SkiView.
-     * @param row: the row of new data to be shown.
+     * @brief searchProgress signal tells how many years the running search
+     *        has searched.
+     * @param progress: the number of searched years.
+     * @param total: the number of years to search.
+     */
+    void searchProgress(int progress, int total);
+
+    /**
+     * @brief searchSuperseded signal tells that a running search was
+     *        replaced by a new one and its partial results should be
+     *        removed.
+     */
+    void searchSuperseded();
+
+    /**
+     * @brief compareData sends a block of compare result data to SkiView.
+     * @param rows: the rows of new data to be shown.
      * @param view: the index of the view that should show the data.
      */
-    void compareData(QVector<QString> row, int view);
+    void compareData(QVector<QVector<QString>> rows, int view);
 
     /**
      * @brief compareNumberOfParticipants signal sends the number of
@@ -114,10 +169,10 @@ signals:
     void timesData(QVector<QString> row);
 
     /**
-     * @brief addNewRow signal sends the best athlete's data to SkiView.
-     * @param row: the row of new data to be shown.
+     * @brief bestAthleteData signal sends the best athletes' data to SkiView.
+     * @param rows: the rows of new data to be shown.
      */
-    void bestAthleteData(QVector<QString> row);
+    void bestAthleteData(QVector<QVector<QString>> rows);
 
     /**
      * @brief nationalityDistributionData sends parameters for nationality
@@ -128,9 +183,9 @@ signals:
 
     /**
      * @brief teamsData signal sends top ten team data to SkiView.
-     * @param row: the row of new data to be shown.
+     * @param rows: the rows of new data to be shown.
      */
-    void teamsData(QVector<QString> row);
+    void teamsData(QVector<QVector<QString>> rows);
 
     /**
      * @brief predictionData signal sends the calculated prediction data to
@@ -152,18 +207,70 @@ signals:
      */
     void refreshDataStorages();
 
+    /**
+     * @brief updateDataStorages signal tells the data retriever to download
+     *        the data of every year again.
+     */
+    void updateDataStorages();
+
     /**
      * @brief dataReady informs the main window that the SkiDataRetriever has
      *        completed some of the data retrieval.
      * @param progress: the amount of progress made.
      * @param total: the total amount the progress param can get.
+     * @param failed: the number of years that couldn't be retrieved.
+     */
+    void dataReady(int progress, int total, int failed);
+
+    /**
+     * @brief saveFailed informs the main window that the retrieved data
+     *        couldn't be saved to the database file.
+     * @param filename: the filename of the database file.
      */
-    void dataReady(int progress, int total);
+    void saveFailed(const QString &filename);
+
+    /**
+     * @brief queryCacheStatistics tells how many requests have been answered
+     *        from the cache. Emitted after every request.
+     * @param hits: the number of requests answered from the cache.
+     * @param misses: the number of requests that were analysed.
+     */
+    void queryCacheStatistics(int hits, int misses);
 
 private:
 
     SkiDataRetriever* m_retriever;
+    QThreadPool*      m_pool;
     bool              m_anonymous;
+    bool              m_parallel;
+    SkiQueryCache     m_cache;
+
+    QScopedPointer<SkiSearchTask> m_search;
+    QString                       m_searchKey;
+    quint64                       m_searchGeneration;
+
+    /**
+     * @brief continueSearch searches the next year of the running search and
+     *        schedules the year after it.
+     * @param generation: the search the step belongs to.
+     * @post results of the year have been emitted, or nothing is done if
+     *       the search has been cancelled or replaced.
+     */
+    void continueSearch(quint64 generation);
+
+    /**
+     * @brief scanPool returns the thread pool years are scanned on.
+     * @return the pool, or nullptr if the years are scanned sequentially.
+     */
+    QThreadPool *scanPool() const;
+
+    /**
+     * @brief finishRequest informs other classes that a request has been
+     *        handled.
+     * @param index of the tab which contains the new data.
+     * @post queryCacheStatistics and dataSent have been emitted.
+     */
+    void finishRequest(int index);
 
     /**
      * @brief rtrnSearchDistanceParameter converts the name of the competition
@@ -174,34 +281,27 @@ private:
     QString rtrnSearchDistanceParameter (QString distance);
 
     /**
-     * @brief timeToInt converts timevalues in the data to float.
-     * @param time: the time of an individual athelete in hh:mm:ss-form.
-     * @return time in hours as float.
+     * @brief timeToHours converts a time of the time column to hours.
+     * @param time: the time of an individual athelete in centiseconds.
+     * @return time in hours as float, 0 if the athlete has no time.
      */
-    float timeToInt (QString time);
+    float timeToHours(qint32 time);
 
     /**
      * @brief createEmit creates the signal to be emitted in search-function.
-     * @param data is the entirety of data from which the emits are created.
-     * @param index of the data.
-     * @param parameter is the type of the competition.
-     * @return returns a vector of required values for addNewRow-signal.
-     */
-    QVector<QString> createEmit(QHash<QString, QVector<QHash<QString, QString>>> data, int index, QString parameter);
-
-    /**
-     * @brief splitName splits the first and last name of the athlete into separate entities.
-     * @param name of the athelete separated with a space.
-     * @return vector containing first and last name.
+     * @param data is the view to the results from which the emits are created.
+     * @param index of the result in the view.
+     * @return returns a vector of required values for the signals.
      */
-    QVector<QString> splitName(QString name);
+    QVector<QString> createEmit(const SkiResultView &data, int index);
 
     /**
-     * @brief Converts float time (in hours) to QString
-     * @param time
+     * @brief Converts time in centiseconds to QString in hh:mm:ss-form.
+     * @param time in centiseconds.
+     * @param centiseconds: adds the centiseconds in hh:mm:ss.cc-form.
      * @return QString of time in correct format
      */
-    QString floatToTimeString(const float time);
+    QString timeToString(qint32 time, bool centiseconds = false);
 };
 
 #endif // SKIANALYZER_H
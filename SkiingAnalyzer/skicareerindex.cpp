@@ -0,0 +1,125 @@
+#include "skicareerindex.h"
+#include "skiresultindex.h"
+
+#include <algorithm>
+
+SkiCareerIndex::SkiCareerIndex()
+{}
+
+void SkiCareerIndex::build(const SkiResultStore &store)
+{
+    clear();
+    for(int year : store.years())
+        setYear(store, year);
+}
+
+void SkiCareerIndex::setYear(const SkiResultStore &store, int year)
+{
+    // Old results of the year are removed only from the athletes who had
+    // results in that year
+    for(int athlete : m_yearAthletes.take(year)){
+        QVector<Entry> &career = m_careers[athlete];
+        career.erase(std::remove_if(career.begin(), career.end(),
+                                    [year](const Entry &entry){
+            return entry.year == year;
+        }), career.end());
+    }
+
+    // Athletes are looked up once per distinct name and birth year ids
+    const SkiResultView data = store.year(year);
+    QHash<quint64, int> athleteOfIds;
+    QVector<int> &yearAthletes = m_yearAthletes[year];
+    for(int i = 0; i < data.size(); ++i){
+        const quint64 ids = (static_cast<quint64>(data.name(i)) << 32)
+                | data.birthYear(i);
+        int athlete = athleteOfIds.value(ids, -1);
+        if(athlete == -1){
+            athlete = athleteOf(data.text(SkiResultStore::Name, i),
+                                data.text(SkiResultStore::BirthYear, i));
+            athleteOfIds.insert(ids, athlete);
+        }
+
+        // Results of the year go after the earlier years and the results of
+        // the same year that are already added
+        QVector<Entry> &career = m_careers[athlete];
+        auto position = std::upper_bound(career.begin(), career.end(), year,
+                                         [](int y, const Entry &entry){
+            return y < entry.year;
+        });
+        if(position == career.begin() || (position - 1)->year != year)
+            yearAthletes.append(athlete);
+
+        Entry entry;
+        entry.year = year;
+        entry.offset = i;
+        career.insert(position, entry);
+    }
+
+    if(yearAthletes.isEmpty())
+        m_yearAthletes.remove(year);
+}
+
+void SkiCareerIndex::clear()
+{
+    m_careers.clear();
+    m_identities.clear();
+    m_names.clear();
+    m_yearAthletes.clear();
+}
+
+int SkiCareerIndex::size() const
+{
+    return m_careers.size();
+}
+
+QVector<int> SkiCareerIndex::athletes(const QString &lastName,
+                                      const QString &firstName) const
+{
+    return m_names.value(nameKey(lastName, firstName));
+}
+
+QVector<int> SkiCareerIndex::results(const SkiResultStore &store,
+                                     int athlete) const
+{
+    QVector<int> rows;
+    if(athlete < 0 || athlete >= m_careers.size())
+        return rows;
+
+    const QVector<Entry> &career = m_careers.at(athlete);
+    rows.reserve(career.size());
+
+    // The rows of a year are looked up once for consecutive results
+    SkiResultView data;
+    int dataYear = 0;
+    for(const Entry &entry : career){
+        if(data.isEmpty() || dataYear != entry.year){
+            data = store.year(entry.year);
+            dataYear = entry.year;
+        }
+        if(entry.offset < data.size())
+            rows.append(data.row(entry.offset));
+    }
+    return rows;
+}
+
+int SkiCareerIndex::athleteOf(const QString &name, const QString &birthYear)
+{
+    const QString identity = SkiResultIndex::normalize(name) + QChar('\n') + birthYear;
+    int athlete = m_identities.value(identity, -1);
+    if(athlete != -1)
+        return athlete;
+
+    athlete = m_careers.size();
+    m_careers.append(QVector<Entry>());
+    m_identities.insert(identity, athlete);
+
+    const QVector<QString> parts = SkiResultIndex::splitName(name);
+    m_names[nameKey(parts[0], parts[1])].append(athlete);
+    return athlete;
+}
+
+QString SkiCareerIndex::nameKey(const QString &lastName, const QString &firstName)
+{
+    return SkiResultIndex::normalize(lastName) + QChar('\n')
+            + SkiResultIndex::normalize(firstName);
+}
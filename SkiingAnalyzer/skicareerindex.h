@@ -0,0 +1,96 @@
+#ifndef SKICAREERINDEX_H
+#define SKICAREERINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiCareerIndex class maps every athlete to their results in
+ *        chronological order. An athlete is identified by the normalized
+ *        name and the birth year. Results are kept as positions inside the
+ *        rows of their year, so the index stays valid when other years of
+ *        the store are replaced and can be updated one year at a time as
+ *        years are retrieved.
+ */
+class SkiCareerIndex
+{
+public:
+    SkiCareerIndex();
+
+    /**
+     * @brief build: Indexes every year of a store
+     * @param store: Store to index
+     * @post Old index is replaced
+     */
+    void build(const SkiResultStore &store);
+
+    /**
+     * @brief setYear: Replaces the results of a year with the results that
+     *        the store has for the year
+     * @param store: Store whose year has changed
+     * @param year: Year to index, a year missing from the store is removed
+     */
+    void setYear(const SkiResultStore &store, int year);
+
+    /**
+     * @brief clear: Removes every athlete
+     */
+    void clear();
+
+    /**
+     * @brief size: Returns the number of athletes
+     * @return Number of athletes
+     */
+    int size() const;
+
+    /**
+     * @brief athletes: Finds the athletes with a name
+     * @param lastName: Last name of the athlete
+     * @param firstName: First name of the athlete
+     * @return Athletes with the name, one for each birth year
+     */
+    QVector<int> athletes(const QString &lastName, const QString &firstName) const;
+
+    /**
+     * @brief results: Returns the results of an athlete
+     * @param store: Store that was indexed
+     * @param athlete: Athlete returned by athletes()
+     * @return Rows of the store in chronological order
+     */
+    QVector<int> results(const SkiResultStore &store, int athlete) const;
+
+private:
+    /**
+     * @brief The Entry struct is one result of an athlete.
+     */
+    struct Entry {
+        qint32 year;
+        qint32 offset;
+    };
+
+    /**
+     * @brief athleteOf: Finds or adds the athlete of a name and birth year
+     * @param name: Name of the athlete as it is stored
+     * @param birthYear: Birth year of the athlete as it is stored
+     * @return Athlete
+     */
+    int athleteOf(const QString &name, const QString &birthYear);
+
+    /**
+     * @brief nameKey: Returns the key of a name in m_names
+     * @param lastName: Last name of the athlete
+     * @param firstName: First name of the athlete
+     * @return Normalized last and first name
+     */
+    static QString nameKey(const QString &lastName, const QString &firstName);
+
+    QVector<QVector<Entry>>      m_careers;
+    QHash<QString, int>          m_identities;
+    QHash<QString, QVector<int>> m_names;
+    QHash<int, QVector<int>>     m_yearAthletes;
+};
+
+#endif // SKICAREERINDEX_H
@@ -0,0 +1,151 @@
+#ifndef SKICOLUMN_H
+#define SKICOLUMN_H
+
+#include <QVector>
+
+#include <algorithm>
+
+/**
+ * @brief The SkiColumn class is a read-mostly array of fixed-width values.
+ *        The values are either owned by the column or borrowed from memory
+ *        owned by someone else, for example a memory-mapped database file.
+ *        Borrowed values are copied to owned storage the first time the
+ *        column is modified.
+ */
+template <typename T>
+class SkiColumn
+{
+public:
+    SkiColumn() : m_data(nullptr), m_size(0), m_mapped(false)
+    {
+        sync();
+    }
+
+    SkiColumn(const SkiColumn &other) :
+        m_owned(other.m_owned), m_data(other.m_data), m_size(other.m_size),
+        m_mapped(other.m_mapped)
+    {
+        if(!m_mapped)
+            sync();
+    }
+
+    SkiColumn &operator=(const SkiColumn &other)
+    {
+        m_owned = other.m_owned;
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_mapped = other.m_mapped;
+        if(!m_mapped)
+            sync();
+        return *this;
+    }
+
+    const T &at(int i) const
+    {
+        Q_ASSERT(i >= 0 && i < m_size);
+        return m_data[i];
+    }
+
+    const T &operator[](int i) const { return at(i); }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    bool isMapped() const { return m_mapped; }
+
+    const T *constData() const { return m_data; }
+    const T *constBegin() const { return m_data; }
+    const T *constEnd() const { return m_data + m_size; }
+
+    /**
+     * @brief map: Makes the column borrow values owned by someone else
+     * @param data: First value
+     * @param size: Number of values
+     * @pre Memory stays valid as long as the column is mapped
+     */
+    void map(const T *data, int size)
+    {
+        m_owned.clear();
+        m_data = data;
+        m_size = size;
+        m_mapped = true;
+    }
+
+    /**
+     * @brief detach: Copies borrowed values to owned storage
+     * @post Column doesn't refer to borrowed memory
+     */
+    void detach()
+    {
+        if(!m_mapped)
+            return;
+
+        m_owned.resize(m_size);
+        std::copy(m_data, m_data + m_size, m_owned.begin());
+        m_mapped = false;
+        sync();
+    }
+
+    void clear()
+    {
+        m_owned.clear();
+        m_mapped = false;
+        sync();
+    }
+
+    void reserve(int size)
+    {
+        detach();
+        m_owned.reserve(size);
+        sync();
+    }
+
+    void append(const T &value)
+    {
+        detach();
+        m_owned.append(value);
+        sync();
+    }
+
+    void append(const T *values, int count)
+    {
+        detach();
+        const int begin = m_owned.size();
+        m_owned.resize(begin + count);
+        std::copy(values, values + count, m_owned.begin() + begin);
+        sync();
+    }
+
+    /**
+     * @brief splice: Replaces count values starting from begin with new
+     *        values. The values around the replaced ones are copied once to
+     *        new owned storage, also when they are borrowed.
+     * @param begin: First value to replace
+     * @param count: Number of values to remove
+     * @param values: Values to insert at begin
+     */
+    void splice(int begin, int count, const QVector<T> &values)
+    {
+        QVector<T> spliced(m_size - count + values.size());
+        T *out = std::copy(m_data, m_data + begin, spliced.begin());
+        out = std::copy(values.constBegin(), values.constEnd(), out);
+        std::copy(m_data + begin + count, m_data + m_size, out);
+
+        m_owned = spliced;
+        m_mapped = false;
+        sync();
+    }
+
+private:
+    void sync()
+    {
+        m_data = m_owned.constData();
+        m_size = m_owned.size();
+    }
+
+    QVector<T> m_owned;
+    const T   *m_data;
+    int        m_size;
+    bool       m_mapped;
+};
+
+#endif // SKICOLUMN_H
@@ -1,127 +1,413 @@
 #include "skidataretriever.h"
+#include "skitrace.h"
+
+#include <algorithm>
+
+namespace {
+
+const QString DefaultUrl = "https://www.finlandiahiihto.fi/Tulokset/Tulosarkisto";
+
+}
 
 SkiDataRetriever::SkiDataRetriever(QObject *parent, bool anonymous) :
     QObject(parent),
-    _data(QJsonObject()),
+    _store(),
+    _staging(),
+    _index(),
+    _careers(),
+    _stagingcareers(),
+    _indexbuilt(false),
+    _careersbuilt(false),
+    _url(qEnvironmentVariable("SKIINGANALYZER_URL", DefaultUrl)),
     _manager(new QNetworkAccessManager(this)),
+    _scheduler(new SkiRequestScheduler(this)),
+    _parsepool(new QThreadPool(this)),
     _postparameters{"", ""},
     _anonymous(anonymous),
+    _fullupdate(false),
     _sentrequests(0),
-    _receivedrequests(0)
+    _receivedrequests(0),
+    _failedrequests(0)
 {
-    connect(_manager, &QNetworkAccessManager::finished,
+    connect(_scheduler, &SkiRequestScheduler::requestStarted,
+            this, &SkiDataRetriever::HandleRequestStarted);
+    connect(_scheduler, &SkiRequestScheduler::replyReady,
             this, &SkiDataRetriever::HandleRequestReply);
+    connect(_scheduler, &SkiRequestScheduler::requestFailed,
+            this, &SkiDataRetriever::HandleRequestFailure);
 
     connect(this, &SkiDataRetriever::ParametersReady,
             this, &SkiDataRetriever::GetSkiDataFromWebServer);
 
-    _data.insert("anonymous", _anonymous);
+    _store.setAnonymous(_anonymous);
 }
 
 SkiDataRetriever::~SkiDataRetriever()
-{}
+{
+    // Parsing workers must not post results to a destroyed retriever
+    _parsepool->waitForDone();
+}
 
-SkiingData SkiDataRetriever::GetSkiingData(int year, QString distance)
+const SkiResultStore &SkiDataRetriever::Store() const
 {
-    SkiingData data;
-    const QString yearString = QString::number(year);
+    return _store;
+}
 
-    // Check if year is found from the database
-    if(_data.contains(yearString) && _data[yearString].isObject()){
-        QJsonObject temp = _data[yearString].toObject();
+const SkiResultIndex &SkiDataRetriever::Index() const
+{
+    // Building the index scans every row of the archive, so it is done on
+    // the first search instead of every time the store is replaced
+    if(!_indexbuilt){
+        SKI_TRACE_SPAN("retrieval", "index");
+        _index.build(_store);
+        _indexbuilt = true;
+    }
+    return _index;
+}
 
-        QStringList keys = {distance};
+const SkiCareerIndex &SkiDataRetriever::Careers() const
+{
+    if(!_careersbuilt){
+        SKI_TRACE_SPAN("retrieval", "careers");
+        _careers.build(_store);
+        _careersbuilt = true;
+    }
+    return _careers;
+}
 
-        if(distance == ""){
-            keys = temp.keys();
-        }
+void SkiDataRetriever::SetRequestLimits(int maxInFlight, int timeout,
+                                        int maxRetries)
+{
+    _scheduler->setMaxInFlight(maxInFlight);
+    _scheduler->setTimeout(timeout);
+    _scheduler->setMaxRetries(maxRetries);
+}
 
-        // Loop through selected distance or all distances
-        for(const QString &key : keys){
-            if(temp[key].isArray()){
-                QVector<QHash<QString, QString>> distanceData =
-                        distanceDataToVector(temp[key].toArray());
-                data.insert(key, distanceData);
+void SkiDataRetriever::SetUrl(const QString &url)
+{
+    _url = url;
+}
+
+QString SkiDataRetriever::Url() const
+{
+    return _url;
+}
+
+SkiingData SkiDataRetriever::GetSkiingData(int year, QString distance)
+{
+    SkiingData data;
+
+    // Select the wanted distance or all distances of the year
+    QVector<SkiResultView> races;
+    if(distance == "")
+        races = _store.races(year);
+    else
+        races.append(_store.race(year, distance));
+
+    for(const SkiResultView &race : races){
+        if(race.isEmpty())
+            continue;
+
+        QVector<QHash<QString, QString>> distanceData;
+        distanceData.reserve(race.size());
+
+        for(int i = 0; i < race.size(); ++i){
+            QHash<QString, QString> skierData;
+            for(int field = 0; field < SkiResultStore::FieldCount; ++field){
+                const SkiResultStore::Field f =
+                        static_cast<SkiResultStore::Field>(field);
+                skierData.insert(SkiResultStore::fieldName(f), race.text(f, i));
             }
+            distanceData.push_back(skierData);
         }
+        data.insert(race.text(SkiResultStore::Distance, 0), distanceData);
     }
     return data;
 }
 
 void SkiDataRetriever::StartSkiingDataRetrieval()
 {
+    SKI_TRACE_SPAN("retrieval", "load");
+
     // Read database file
-    bool fileFound = ReadDataFromFile(_filename, _data);
+    bool fileFound = ReadDataFromFile(_filename, _store);
+
+    // Convert the JSON database of older versions to a snapshot
+    if(!fileFound && ReadDataFromJson(_jsonFilename, _store))
+        fileFound = SaveDataToFile(_filename, _store);
 
-    if(!fileFound)
-        // Start data retrieval
-        MakeGetRequest();
+    // Check if anonymous mode in file is different than in database
+    if(!fileFound || _store.isAnonymous() != _anonymous)
+        UpdateDataBase();
     else{
-        // Check if anonymous mode in file is different than in database
-        QJsonValue temp = _data.value("anonymous");
-        if(temp == QJsonValue::Undefined || temp.toBool() != _anonymous)
-            UpdateDataBase();
-        else
-            // Indicate that dataretriever is ready
-            emit DataReady(0, 0);
+        _careers.clear();
+        _careersbuilt = false;
+        PublishStore();
     }
 }
 
 void SkiDataRetriever::UpdateDataBase()
 {
-    // Remove database file if found
-    if(QFile::exists(_filename)){
-        QFile file(_filename);
-        file.remove();
+    // The new database is built separately and replaces the old one only
+    // when every year has been retrieved
+    _staging = SkiResultStore();
+    _staging.setAnonymous(_anonymous);
+    _stagingcareers.clear();
+    _fullupdate = true;
+
+    QDate date = QDate::currentDate();
+    const int endYear = date.year();
+
+    _pendingyears.clear();
+    for(int i = _startyear; i <= endYear; ++i)
+        _pendingyears.append(i);
+
+    MakeGetRequest();
+}
+
+void SkiDataRetriever::RefreshDataBase()
+{
+    if(_store.size() == 0 || _store.isAnonymous() != _anonymous){
+        UpdateDataBase();
+        return;
+    }
+
+    QDate date = QDate::currentDate();
+    const int endYear = date.year();
+
+    // Fetched years are merged to a copy of the database. A year that can't
+    // be retrieved keeps its old results.
+    // The careers of the merged years are updated in the copy, so the
+    // careers of the old store are built first
+    _staging = _store;
+    _stagingcareers = Careers();
+    _fullupdate = false;
+
+    // Historical results don't change, so only the most recent years and
+    // the years that have never been fetched are requested again
+    _pendingyears.clear();
+    for(int i = _startyear; i <= endYear; ++i){
+        SkiResultStore::YearInfo info;
+        const bool fetched = _store.yearInfo(i, info) || _store.containsYear(i);
+        if(!fetched || i > endYear - _refreshyears)
+            _pendingyears.append(i);
     }
 
-    _data = QJsonObject();
-    _data.insert("anonymous", _anonymous);
     MakeGetRequest();
 }
 
-void SkiDataRetriever::HandleRequestReply(QNetworkReply *reply)
+bool SkiDataRetriever::ExportData(const QString &filename)
+{
+    return SaveDataToJson(filename, _store);
+}
+
+bool SkiDataRetriever::ImportData(const QString &filename)
+{
+    SkiResultStore store;
+    if(!ReadDataFromJson(filename, store))
+        return false;
+
+    // The database is replaced only if the imported data could be saved
+    if(!SaveDataToFile(_filename, store))
+        return false;
+
+    _changedyears += _store.years();
+    _changedyears += store.years();
+    _store = store;
+    emit StoreReplaced();
+    _careers.clear();
+    _careersbuilt = false;
+
+    PublishStore();
+    return true;
+}
+
+void SkiDataRetriever::HandleRequestStarted(int id, QNetworkReply *reply)
 {
-    QString data = reply->readAll();
-    if(reply->operation() == 2){
+    if(id == _getrequestid)
+        return;
+
+    // Result pages are parsed on the thread pool while they are downloaded.
+    // A retry starts the page from the beginning with a new job.
+    const bool anonymous = _anonymous;
+
+    // The span of a year covers its retries, so only the first attempt
+    // begins it. The get request isn't traced as a request.
+    if(!_parsejobs.contains(id))
+        SKI_TRACE_BEGIN("network", "request", id);
+    SKI_TRACE_COUNT("network.attempts", 1);
+    QSharedPointer<SkiPageParseJob> job = QSharedPointer<SkiPageParseJob>::create(
+                _parsepool, [this, id, anonymous](SkiResultPageParser &parser){
+        SKI_TRACE_SPAN("parse", "records");
+        YearBlock block;
+        block.year = parser.year();
+        block.records = parser.takeRecords();
+        if(anonymous)
+            Anonymize(block.records);
+        block.contentHash = SkiResultStore::contentHash(block.records);
+        SKI_TRACE_VALUE("parse.records", block.records.size());
+
+        // Parsed years are merged to the store in the retriever's thread
+        QMetaObject::invokeMethod(this, [this, id, block](){
+            HandleParsedYear(id, block);
+        }, Qt::QueuedConnection);
+    });
+    _parsejobs.insert(id, job);
+
+    connect(reply, &QNetworkReply::readyRead, this, [job, reply](){
+        const QByteArray data = reply->readAll();
+        SKI_TRACE_COUNT("network.bytes", data.size());
+        job->append(data);
+    });
+}
+
+void SkiDataRetriever::HandleRequestReply(int id, QNetworkReply *reply)
+{
+    if(id == _getrequestid){
         // Handle get request reply
-        HandleGetReply(data);
+        HandleGetReply(reply->readAll());
 
         if(_postparameters[0] != "" && _postparameters[1] != "")
             emit ParametersReady();
+        else
+            HandleRequestFailure(id, "Request parameters not found");
+        return;
     }
-    else if(reply->operation() == 4){
-        // Handle post request reply
-        HandlePostReply(data);
-        ++_receivedrequests;
-        // Emit status of the retrieveal
-        emit DataReady(_receivedrequests, _sentrequests);
-        if(_sentrequests == _receivedrequests){
-            // All data is retrieved
-            SaveDataToFile(_filename, _data);
-            _receivedrequests = 0;
-            _sentrequests = 0;
-            // Indicate that dataretriever is ready
-            emit DataReady(0, 0);
+
+    // Handle post request reply. The year is counted as received when its
+    // page has been parsed.
+    SKI_TRACE_END("network", "request", id);
+    QSharedPointer<SkiPageParseJob> job = _parsejobs.take(id);
+    if(job)
+        job->finish(reply->readAll());
+}
+
+void SkiDataRetriever::HandleParsedYear(int id, const YearBlock &block)
+{
+    SKI_TRACE_SPAN("retrieval", "merge");
+
+    // A page of some other year means that the server didn't accept the
+    // request. A page that doesn't fit the store fails the same way.
+    if(!HandlePostReply(id, block))
+        ++_failedrequests;
+
+    ++_receivedrequests;
+    FinishRequest();
+}
+
+void SkiDataRetriever::HandleRequestFailure(int id, const QString &error)
+{
+    Q_UNUSED(error)
+    SKI_TRACE_COUNT("network.failures", 1);
+
+    _parsejobs.remove(id);
+
+    if(id == _getrequestid){
+        // No year can be requested without the parameters
+        _failedrequests = _pendingyears.size();
+        _sentrequests = _pendingyears.size();
+        _receivedrequests = _sentrequests;
+        _pendingyears.clear();
+        FinishRetrieval();
+        return;
+    }
+
+    SKI_TRACE_END("network", "request", id);
+    ++_failedrequests;
+    ++_receivedrequests;
+    FinishRequest();
+}
+
+void SkiDataRetriever::FinishRequest()
+{
+    // Emit status of the retrieveal
+    emit DataReady(_receivedrequests, _sentrequests, _failedrequests);
+    if(_sentrequests == _receivedrequests)
+        FinishRetrieval();
+}
+
+void SkiDataRetriever::FinishRetrieval()
+{
+    SKI_TRACE_END("retrieval", "update", 0);
+
+    // A full update is published only if every year was retrieved. In an
+    // incremental refresh every retrieved year is complete on its own.
+    if(_failedrequests == 0 || !_fullupdate){
+        // A full update replaces every year, a refresh only the merged ones
+        if(_fullupdate){
+            _changedyears += _store.years();
+            _changedyears += _staging.years();
         }
+        else{
+            _changedyears += _mergedyears;
+        }
+        _store = _staging;
+        _careers = _stagingcareers;
+        _careersbuilt = true;
+        emit StoreReplaced();
+
+        // The retrieved data is still served if it can't be saved
+        if(!SaveDataToFile(_filename, _store))
+            emit SaveFailed(_filename);
+    }
+    else if(_store.isAnonymous() != _anonymous){
+        // Data of the wrong mode must not be served
+        _changedyears += _store.years();
+        _store.clear();
+        _store.setAnonymous(_anonymous);
+        _careers.clear();
+        _careersbuilt = true;
+        emit StoreReplaced();
     }
+    _staging = SkiResultStore();
+    _stagingcareers.clear();
+    _mergedyears.clear();
 
-    reply->deleteLater();
+    const int failed = _failedrequests;
+    _receivedrequests = 0;
+    _sentrequests = 0;
+    _failedrequests = 0;
+
+    PublishStore(failed);
 }
 
-void SkiDataRetriever::GetSkiDataFromWebServer()
+void SkiDataRetriever::PublishStore(int failed)
 {
-    QDate date = QDate::currentDate();
-    const int startYear = 1974;
-    const int endYear = date.year();
+    SKI_TRACE_SPAN("retrieval", "publish");
+
+    // Searches look up rows from the index, so it is rebuilt on the next
+    // search after the store is replaced
+    _index.clear();
+    _indexbuilt = false;
+
+    // Cached analyses of the changed years are dropped before new requests
+    if(!_changedyears.isEmpty()){
+        std::sort(_changedyears.begin(), _changedyears.end());
+        _changedyears.erase(std::unique(_changedyears.begin(), _changedyears.end()),
+                            _changedyears.end());
+        emit YearsChanged(_changedyears);
+        _changedyears.clear();
+    }
 
-    for(int i = startYear; i <= endYear; ++i) {
-        MakePostRequest(i);
+    // Indicate that dataretriever is ready
+    emit DataReady(0, 0, failed);
+}
+
+void SkiDataRetriever::GetSkiDataFromWebServer()
+{
+    for(int year : _pendingyears) {
+        _scheduler->enqueue(year, [this, year](){
+            return MakePostRequest(year);
+        });
         ++_sentrequests;
     }
+    _pendingyears.clear();
+
+    if(_sentrequests == 0)
+        FinishRetrieval();
 }
 
-void SkiDataRetriever::MakePostRequest(int year) const
+QNetworkReply *SkiDataRetriever::MakePostRequest(int year) const
 {
     const QVector<QPair<QString, QString>> multipartData = {
         {"\"__EVENTTARGET\"", "dnn$ctr1025$Etusivu$cmdHaeTulokset"},
@@ -157,24 +443,33 @@ void SkiDataRetriever::MakePostRequest(int year) const
     QNetworkRequest request(_url);
     request.setRawHeader("Connection", "keep-alive");
     request.setRawHeader("Upgrade-insecure-requests", "1");
-    request.setRawHeader("Origin", "https://www.finlandiahiihto.fi");
+    request.setRawHeader("Origin", QUrl(_url).adjusted(QUrl::RemovePath | QUrl::RemoveQuery)
+                                             .toString().toUtf8());
     request.setRawHeader("Referer", _url.toUtf8());
 
     QNetworkReply* reply = _manager->post(request, multipart);
     multipart->setParent(reply);
+    return reply;
 }
 
-void SkiDataRetriever::MakeGetRequest() const
+void SkiDataRetriever::MakeGetRequest()
 {
-    QNetworkRequest request;
-    request.setUrl(QUrl(_url));
+    // The update is timed from the request of the form to the end of the
+    // last year
+    SKI_TRACE_BEGIN("retrieval", "update", 0);
 
-    request.setRawHeader("Connection", "keep-alive");
-    request.setRawHeader("Upgrade-insecure-requests", "1");
+    _scheduler->enqueue(_getrequestid, [this](){
+        QNetworkRequest request;
+        request.setUrl(QUrl(_url));
 
-    _manager->get(request);
+        request.setRawHeader("Connection", "keep-alive");
+        request.setRawHeader("Upgrade-insecure-requests", "1");
+
+        return _manager->get(request);
+    });
 }
 
+
 void SkiDataRetriever::HandleGetReply(const QString &page)
 {
     const int parameters = 2;
@@ -196,153 +491,228 @@ void SkiDataRetriever::HandleGetReply(const QString &page)
     }
 }
 
-void SkiDataRetriever::HandlePostReply(const QString &page)
+void SkiDataRetriever::Anonymize(QVector<SkiResultStore::RawRecord> &records)
 {
-    int infoStartIndex = 0;
-    int infoEndIndex = 0;
-
-    const QString infoStart = ">";
-    const QString infoEnd = "<";
-    const QString yearid = "dnn_ctr1025_Etusivu_ddlVuosi2x";
-    const QString selected = "selected=";
-    const QString id = "dnn_ctr1025_Etusivu_dgrTulokset_ctl00__";
-    const QString cellStart = "<td";
-
-    // Search page for selected year
-    infoStartIndex = page.indexOf(yearid, infoStartIndex);
-    infoStartIndex = page.indexOf(selected, infoStartIndex);
-    infoStartIndex = page.indexOf(infoStart, infoStartIndex) + infoStart.length();
-    infoEndIndex = page.indexOf(infoEnd, infoStartIndex);
-
-    QString year = page.mid(infoStartIndex, infoEndIndex-infoStartIndex);
-
-    infoStartIndex = infoEndIndex;
-
-    const QStringList names = {"year", "distance", "time", "placement",
-                               "placementMale", "placementFemale", "sex",
-                               "name", "locality", "nationality", "birthYear",
-                               "team"};
-
     // Lists for data to censor
-    const QStringList censorship {"sex", "placementMale", "placementFemale"};
-    const QStringList hashCensorship {"name", "locality", "birthYear"};
+    const QVector<SkiResultStore::Field> censorship {
+        SkiResultStore::Sex, SkiResultStore::PlacementMale,
+        SkiResultStore::PlacementFemale};
+    const QVector<SkiResultStore::Field> hashCensorship {
+        SkiResultStore::Name, SkiResultStore::Locality,
+        SkiResultStore::BirthYear};
+
+    // Same names and localities repeat on the page, so every distinct value
+    // is hashed only once
+    QHash<QByteArray, QByteArray> hashes;
+    const QByteArray redacted = SkiResultStore::RedactedText;
+
+    for(SkiResultStore::RawRecord &record : records){
+        for(SkiResultStore::Field field : censorship)
+            record.cells[field] = redacted;
+
+        for(SkiResultStore::Field field : hashCensorship){
+            QByteArray &cell = record.cells[field];
+            auto it = hashes.constFind(cell);
+            if(it == hashes.constEnd()){
+                QByteArray hash = QCryptographicHash::hash(cell,
+                                                   QCryptographicHash::Md5);
+                const int hashLength = 10;
+                it = hashes.insert(cell, hash.toHex().left(hashLength));
+            }
+            cell = it.value();
+        }
+    }
+}
 
-    QHash<QString, QJsonArray> temp;
+bool SkiDataRetriever::HandlePostReply(int requestedYear,
+                                       const YearBlock &block)
+{
+    const int yearNumber = block.year;
+    if(yearNumber != requestedYear)
+        return false;
 
-    // Search the page for skier info
-    for(int index = 0; true; ++index){
-        infoStartIndex = page.indexOf(id + QString::number(index),
-                                      infoStartIndex);
+    const QVector<SkiResultStore::RawRecord> &records = block.records;
+    const quint64 hash = block.contentHash;
+
+    // An empty page never replaces results that are already in the store
+    if(records.isEmpty() && _staging.containsYear(yearNumber))
+        return true;
+
+    // The year is merged to the store only if its content has changed since
+    // the last fetch
+    SkiResultStore::YearInfo info;
+    if(!_staging.yearInfo(yearNumber, info) || info.contentHash != hash
+            || info.recordCount != static_cast<quint32>(records.size())){
+        // Careers are updated as each year arrives, not after the retrieval
+        if(!_staging.setYear(yearNumber, records))
+            return false;
+        _stagingcareers.setYear(_staging, yearNumber);
+        _mergedyears.append(yearNumber);
+    }
 
-        if(infoStartIndex == -1){
-            break;
-        }
+    info.year = yearNumber;
+    info.recordCount = static_cast<quint32>(records.size());
+    info.contentHash = hash;
+    info.fetchedAt = QDateTime::currentMSecsSinceEpoch();
+    _staging.setYearInfo(info);
+    return true;
+}
 
-        QJsonObject info;
-        QString distance = "";
-        for(const QString &name: names){
-            infoStartIndex = page.indexOf(cellStart, infoStartIndex);
-            infoStartIndex = page.indexOf(infoStart, infoStartIndex) + infoStart.length();
-            infoEndIndex = page.indexOf(infoEnd, infoStartIndex);
-
-            QString data = page.mid(infoStartIndex, infoEndIndex-infoStartIndex);
-            infoStartIndex = infoEndIndex;
-
-            if(data == "&nbsp;")
-                data = "";
-
-            if(name == "distance")
-                distance = data;
-
-            if(_anonymous){
-                // save anonymized data
-                if(censorship.contains(name))
-                    data = "[Redacted]";
-                else if(hashCensorship.contains(name)){
-                    QByteArray hash = QCryptographicHash::hash(data.toUtf8(),
-                                                       QCryptographicHash::Md5);
-                    const int hashLength = 10;
-                    data = QString(hash.toHex()).left(hashLength);
-                }
-            }
+bool SkiDataRetriever::SaveDataToFile(const QString &filename,
+                                      const SkiResultStore &store)
+{
+    SKI_TRACE_SPAN("storage", "save");
+
+    // The store and its copies may still map the current snapshot, so it is
+    // never written over
+    const QVector<QPair<qint64, QString>> snapshots = SnapshotFiles(filename);
+    const qint64 generation = snapshots.isEmpty() ? 1 : snapshots.first().first + 1;
+    const QFileInfo info(filename);
+    const QString path = info.dir().filePath(QString("%1.%2.%3")
+                                             .arg(info.completeBaseName())
+                                             .arg(generation)
+                                             .arg(info.suffix()));
+    if(!SkiSnapshot::write(path, store))
+        return false;
 
-            info[name] = data;
-        }
+    for(const QPair<qint64, QString> &snapshot : snapshots)
+        QFile::remove(snapshot.second);
 
-        // Create new distance
-        if(!temp.contains(distance)){
-            temp.insert(distance, QJsonArray());
-        }
+    return true;
+}
 
-        temp[distance].append(info);
+bool SkiDataRetriever::ReadDataFromFile(const QString &filename,
+                                        SkiResultStore &store)
+{
+    SKI_TRACE_SPAN("storage", "read");
+
+    // A damaged generation falls back to the previous one if it still exists
+    for(const QPair<qint64, QString> &snapshot : SnapshotFiles(filename)){
+        if(SkiSnapshot::read(snapshot.second, store))
+            return true;
     }
+    return false;
+}
 
-    // Transform data from QHash to QJsonObject
-    QJsonObject skiers;
-    QHash<QString, QJsonArray>::iterator i;
-    for (i = temp.begin(); i != temp.end(); ++i) {
-        skiers[i.key()] = i.value();
+QVector<QPair<qint64, QString>> SkiDataRetriever::SnapshotFiles(const QString &filename)
+{
+    const QFileInfo info(filename);
+    const QString prefix = info.completeBaseName() + ".";
+    const QString suffix = "." + info.suffix();
+
+    QVector<QPair<qint64, QString>> snapshots;
+    if(info.exists())
+        snapshots.append(qMakePair(qint64(0), info.filePath()));
+
+    const QDir dir = info.dir();
+    for(const QString &name : dir.entryList(QStringList(prefix + "*" + suffix),
+                                            QDir::Files)){
+        bool ok = false;
+        const qint64 generation = name.mid(prefix.size(),
+                                           name.size() - prefix.size() - suffix.size())
+                                      .toLongLong(&ok);
+        if(ok && generation > 0)
+            snapshots.append(qMakePair(generation, dir.filePath(name)));
     }
 
-    _data[year] = skiers;
+    std::sort(snapshots.begin(), snapshots.end(),
+              [](const QPair<qint64, QString> &a, const QPair<qint64, QString> &b){
+        return a.first > b.first;
+    });
+    return snapshots;
 }
 
-bool SkiDataRetriever::SaveDataToFile(const QString &filename,
-                                      const QJsonObject &data)
+bool SkiDataRetriever::SaveDataToJson(const QString &filename,
+                                      const SkiResultStore &store)
 {
+    SKI_TRACE_SPAN("storage", "export");
+
     QFile file(filename);
     if(!file.open(QIODevice::WriteOnly)){
         return false;
     }
 
+    QJsonObject data;
+    data.insert("anonymous", store.isAnonymous());
+
+    // Write every race of every year as an array of skier objects
+    for(int year : store.years()){
+        QJsonObject skiers;
+        for(const SkiResultView &race : store.races(year)){
+            QJsonArray distanceData;
+            for(int i = 0; i < race.size(); ++i){
+                QJsonObject info;
+                for(int field = 0; field < SkiResultStore::FieldCount; ++field){
+                    const SkiResultStore::Field f =
+                            static_cast<SkiResultStore::Field>(field);
+                    info[SkiResultStore::fieldName(f)] = race.text(f, i);
+                }
+                distanceData.append(info);
+            }
+            skiers[race.text(SkiResultStore::Distance, 0)] = distanceData;
+        }
+        data[QString::number(year)] = skiers;
+    }
+
     QJsonDocument dataDoc(data);
     file.write(dataDoc.toJson());
 
     return true;
 }
 
-bool SkiDataRetriever::ReadDataFromFile(const QString &filename,
-                                        QJsonObject &data)
+bool SkiDataRetriever::ReadDataFromJson(const QString &filename,
+                                        SkiResultStore &store)
 {
+    SKI_TRACE_SPAN("storage", "import");
+
     QFile file(filename);
     if(!file.open(QIODevice::ReadOnly)){
         return false;
     }
 
     QJsonDocument dataDoc(QJsonDocument::fromJson(file.readAll()));
+    const QJsonObject data = dataDoc.object();
 
-    data = dataDoc.object();
-    return true;
-}
-
-QHash<QString, QString> SkiDataRetriever::SkierDataToHash(QJsonObject object)
-{
-    QStringList keys = object.keys();
-
-    QHash<QString, QString> data;
-
-    for(const QString &key : keys){
-        if(object[key].isString()){
-            data.insert(key, object[key].toString());
-        }
+    if(!data.value("anonymous").isBool()){
+        return false;
     }
-    return data;
-}
-
-QVector<QHash<QString, QString>>
-SkiDataRetriever::distanceDataToVector(QJsonArray array)
-{
-    QVector<QHash<QString, QString>> data;
-    const int size = array.size();
 
-    // Loop through all the skiers
-    for(int i = 0; i < size; ++i){
-        if(array.at(i).isObject()){
-            QJsonObject object = array.at(i).toObject();
-
-            QHash<QString, QString> skierData = SkierDataToHash(object);
-            data.push_back(skierData);
+    store.clear();
+    store.setAnonymous(data.value("anonymous").toBool());
+
+    QString names[SkiResultStore::FieldCount];
+    for(int field = 0; field < SkiResultStore::FieldCount; ++field)
+        names[field] = SkiResultStore::fieldName(
+                    static_cast<SkiResultStore::Field>(field));
+
+    for(auto yearIt = data.constBegin(); yearIt != data.constEnd(); ++yearIt){
+        if(!yearIt.value().isObject())
+            continue;
+
+        QVector<SkiResultStore::RawRecord> records;
+        const QJsonObject skiers = yearIt.value().toObject();
+
+        // Loop through all the distances and skiers of the year
+        for(auto distanceIt = skiers.constBegin();
+            distanceIt != skiers.constEnd(); ++distanceIt){
+            const QJsonArray array = distanceIt.value().toArray();
+            for(const QJsonValue &value : array){
+                if(!value.isObject())
+                    continue;
+
+                const QJsonObject object = value.toObject();
+                SkiResultStore::RawRecord record;
+                for(int field = 0; field < SkiResultStore::FieldCount; ++field)
+                    record.cells[field] = object.value(names[field])
+                                                .toString().toUtf8();
+                records.append(record);
+            }
+        }
+        if(!store.setYear(yearIt.key().toInt(), records)){
+            store.clear();
+            return false;
         }
     }
-    return data;
+
+    return true;
 }
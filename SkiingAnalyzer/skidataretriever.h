@@ -13,7 +13,19 @@
 #include <QHash>
 #include <QPair>
 #include <QDate>
+#include <QDateTime>
 #include <QCryptographicHash>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QDir>
+#include <QFileInfo>
+
+#include "skiresultstore.h"
+#include "skiresultindex.h"
+#include "skicareerindex.h"
+#include "skisnapshot.h"
+#include "skirequestscheduler.h"
+#include "skipageparsejob.h"
 
 typedef QHash<QString, QVector<QHash<QString, QString>>> SkiingData;
 
@@ -30,14 +42,90 @@ public:
     explicit SkiDataRetriever(QObject *parent = nullptr, bool anonymous = false);
     ~SkiDataRetriever();
 
+    /**
+     * @brief Store: Returns the in-memory result store for scanning
+     * @return Result store of the retriever
+     * @pre Data is in internal database
+     */
+    const SkiResultStore &Store() const;
+
+    /**
+     * @brief Index: Returns the index of the names, teams, nationalities and
+     *        localities of the result store
+     * @return Index built from the current result store. The index is
+     *         built on the first call after the store is replaced.
+     * @pre Data is in internal database
+     */
+    const SkiResultIndex &Index() const;
+
+    /**
+     * @brief Careers: Returns the results of every athlete in chronological
+     *        order
+     * @return Career index of the current result store. The careers are
+     *         built on the first call after the store is loaded or imported.
+     * @pre Data is in internal database
+     */
+    const SkiCareerIndex &Careers() const;
+
+    /**
+     * @brief SetRequestLimits: Sets how the requests to the server are run
+     * @param maxInFlight: Number of requests run at the same time
+     * @param timeout: Time in milliseconds a request may go without
+     *        receiving data before it is aborted
+     * @param maxRetries: Number of times a failed request is retried
+     */
+    void SetRequestLimits(int maxInFlight, int timeout, int maxRetries);
+
+    /**
+     * @brief SetUrl: Sets the address of the result archive. By default the
+     *        address is read from the SKIINGANALYZER_URL environment variable
+     *        and if it isn't set, the archive of Finlandia hiihto is used.
+     * @param url: Address the get and post requests are made to
+     * @pre No retrieval is running
+     */
+    void SetUrl(const QString &url);
+
+    /**
+     * @brief Url: Returns the address of the result archive
+     * @return Address the get and post requests are made to
+     */
+    QString Url() const;
+
 signals:
     /**
      * @brief DataReady: Notifies that the data is retrieved and retriever is
-     * ready to serve data
+     * ready to serve data. Progress and total are 0 when the retrieval has
+     * finished.
      * @param progress: Number of received and handeled requests
      * @param total: Total number of requests
+     * @param failed: Number of years that couldn't be retrieved. If a full
+     *        update fails, the old database is kept. If a refresh fails, the
+     *        failed years keep their old results.
+     */
+    void DataReady(int progress, int total, int failed = 0);
+
+    /**
+     * @brief YearsChanged: Notifies that the results of some years have
+     * changed. Emitted just before DataReady(0, 0) when the database is
+     * replaced.
+     * @param years: Years that were changed, added or removed
+     */
+    void YearsChanged(const QVector<int> &years);
+
+    /**
+     * @brief StoreReplaced: Notifies that the result store has been
+     * replaced or cleared. Copies of the old store keep its columns in
+     * memory until they are released. Emitted before DataReady(0, 0).
      */
-    void DataReady(int progress, int total);
+    void StoreReplaced();
+
+    /**
+     * @brief SaveFailed: Notifies that the retrieved data couldn't be saved
+     * to the database file. The data is used until the program is closed.
+     * Emitted before DataReady(0, 0).
+     * @param filename: Filename of the database file
+     */
+    void SaveFailed(const QString &filename);
 
     /**
      * @brief ParametersReady: Internal signal to notify that post request
@@ -68,36 +156,104 @@ public slots:
     void StartSkiingDataRetrieval();
 
     /**
-     * @brief UpdateDataBase: Deletes the local file and starts a new data
-     * retrieval and therefore creates the file again with new data.
+     * @brief UpdateDataBase: Starts a new data retrieval of every year. The
+     * database and its file are replaced only if every year is retrieved.
      * @post Data retrieval is started
      */
     void UpdateDataBase();
 
+    /**
+     * @brief RefreshDataBase: Starts an incremental data retrieval. Only the
+     * most recent years and the years that have never been fetched are
+     * requested. Fetched years are merged to the database if their content
+     * has changed. Falls back to UpdateDataBase if the database is empty.
+     * @post Data retrieval is started
+     */
+    void RefreshDataBase();
+
+    /**
+     * @brief ExportData: Writes the database to a JSON file
+     * @param filename: Filename of the JSON file
+     * @return Boolean indicating if exporting was successful
+     */
+    bool ExportData(const QString &filename);
+
+    /**
+     * @brief ImportData: Replaces the database with data read from a JSON
+     *        file written by ExportData or by older versions of the software
+     * @param filename: Filename of the JSON file
+     * @return Boolean indicating if importing was successful. The database
+     *         isn't replaced if the data can't be saved to the database file.
+     * @post On success the database file is rewritten and DataReady(0, 0) is
+     *       emitted
+     */
+    bool ImportData(const QString &filename);
+
 private slots:
+    /**
+     * @brief HandleRequestStarted: Starts parsing the result page of a post
+     *        request on the thread pool while it is downloaded
+     * @param id: Year of the post request or _getrequestid
+     * @param reply: Reply to post or get request
+     */
+    void HandleRequestStarted(int id, QNetworkReply *reply);
+
     /**
      * @brief HandleRequestReply: Handles post and get request replies
+     * @param id: Year of the post request or _getrequestid
      * @param reply: Reply to post or get request
      */
-    void HandleRequestReply(QNetworkReply *reply);
+    void HandleRequestReply(int id, QNetworkReply *reply);
 
     /**
-     * @brief GetSkiDataFromWebServer: Makes all post requests to
-     *        Finlandiahiihto's servers
+     * @brief HandleRequestFailure: Handles a request that failed after all
+     *        retries
+     * @param id: Year of the post request or _getrequestid
+     * @param error: Description of the error
+     */
+    void HandleRequestFailure(int id, const QString &error);
+
+    /**
+     * @brief GetSkiDataFromWebServer: Queues post requests of all pending
+     *        years to Finlandiahiihto's servers
      */
     void GetSkiDataFromWebServer();
 
 private:
     /**
-     * @brief MakePostRequest: Makes a get request to the server
+     * @brief The YearBlock struct holds the parsed records of one year.
+     */
+    struct YearBlock {
+        int                                year;
+        QVector<SkiResultStore::RawRecord> records;
+        quint64                            contentHash;
+    };
+
+    /**
+     * @brief HandleParsedYear: Merges a parsed year to the database and
+     *        reports progress
+     * @param id: Year of the post request
+     * @param block: Records parsed from the page
+     */
+    void HandleParsedYear(int id, const YearBlock &block);
+
+    /**
+     * @brief Anonymize: Censors and hashes the personal data of records
+     * @param records: Records to anonymize
+     */
+    static void Anonymize(QVector<SkiResultStore::RawRecord> &records);
+
+    /**
+     * @brief MakePostRequest: Makes a post request to the server
      * @param year: Year from which the data is fetched from Finlandia hiihto
+     * @return Reply of the request
      */
-    void MakePostRequest(int year) const;
+    QNetworkReply *MakePostRequest(int year) const;
 
     /**
-     * @brief MakeGetRequest: Makes a post request to the server
+     * @brief MakeGetRequest: Queues a get request to the server
      */
-    void MakeGetRequest() const;
+    void MakeGetRequest();
 
     /**
      * @brief HandleGetReply: Handles get request reply
@@ -106,50 +262,108 @@ private:
     void HandleGetReply(const QString &page);
 
     /**
-     * @brief HandlePostReply: Handles post request reply
-     * @param page: Whole web page in QString
+     * @brief HandlePostReply: Merges the parsed page of a post request to the
+     *        database if its content has changed
+     * @param requestedYear: Year that was requested
+     * @param block: Records parsed from the page
+     * @return Boolean indicating if the page contained the requested year and
+     *         its results could be stored
      */
-    void HandlePostReply(const QString &page);
+    bool HandlePostReply(int requestedYear, const YearBlock &block);
 
     /**
-     * @brief SaveDataToFile: Saves retrieved data to file
-     * @param filename: Filename of the database file
-     * @param data: Database from which a copy is made to a file
+     * @brief FinishRequest: Reports progress after a post request has been
+     *        handled and finishes the retrieval after the last one
+     */
+    void FinishRequest();
+
+    /**
+     * @brief FinishRetrieval: Publishes the retrieved data and saves it to
+     *        the database file unless a full update has failed
+     * @post DataReady(0, 0, failed) is emitted
+     */
+    void FinishRetrieval();
+
+    /**
+     * @brief PublishStore: Drops the index of the result store, reports
+     *        the changed years and indicates that the retriever is ready
+     * @param failed: Number of years that couldn't be retrieved
+     * @post YearsChanged is emitted if years have changed and
+     *       DataReady(0, 0, failed) is emitted
+     */
+    void PublishStore(int failed = 0);
+
+    /**
+     * @brief SaveDataToFile: Saves retrieved data to a new generation of the
+     *        binary snapshot file and removes the older generations. A file
+     *        that is still mapped can't be replaced or removed on Windows,
+     *        so such a file is left to be removed by a later save.
+     * @param filename: Filename of the database file, for example data.skis
+     *        is saved as data.1.skis, data.2.skis and so on
+     * @param store: Database from which a copy is made to a file
      * @return Boolean indicating if saving was successful
      */
-    bool SaveDataToFile(const QString &filename, const QJsonObject &data);
+    bool SaveDataToFile(const QString &filename, const SkiResultStore &store);
 
     /**
-     * @brief ReadDataFromFile: Reads saved data from a file
+     * @brief ReadDataFromFile: Reads saved data from the newest generation of
+     *        the binary snapshot file that can be read
      * @param filename: Filename of the database file
-     * @param data: Object to which the database file is read
+     * @param store: Store to which the database file is read
      * @return Boolean indicating if reading was successful
      */
-    bool ReadDataFromFile(const QString &filename, QJsonObject &data);
+    bool ReadDataFromFile(const QString &filename, SkiResultStore &store);
 
     /**
-     * @brief SkierDataToHash: Copies skier data from QJsonObject to QHash
-     * @param object: QJsonObject containing skier data
-     * @return QHash containing skier data
+     * @brief SnapshotFiles: Lists the generations of a snapshot file
+     * @param filename: Filename of the database file. The file itself is the
+     *        generation 0 written by older versions of the software.
+     * @return Generations and paths of the existing files, newest first
      */
-    QHash<QString, QString> SkierDataToHash(QJsonObject object);
+    static QVector<QPair<qint64, QString>> SnapshotFiles(const QString &filename);
 
     /**
-     * @brief distanceDataToVector: Copies distance data from QJsonArray to
-     *        QVector
-     * @param array: QJsonArray containing distance data
-     * @return QVector containing distance data
+     * @brief SaveDataToJson: Saves data to a JSON file
+     * @param filename: Filename of the JSON file
+     * @param store: Database from which a copy is made to a file
+     * @return Boolean indicating if saving was successful
+     */
+    bool SaveDataToJson(const QString &filename, const SkiResultStore &store);
+
+    /**
+     * @brief ReadDataFromJson: Reads data from a JSON file
+     * @param filename: Filename of the JSON file
+     * @param store: Store to which the JSON file is read
+     * @return Boolean indicating if reading was successful
      */
-    QVector<QHash<QString, QString>> distanceDataToVector(QJsonArray array);
+    bool ReadDataFromJson(const QString &filename, SkiResultStore &store);
 
-    QJsonObject _data;
-    const QString _url = "https://www.finlandiahiihto.fi/Tulokset/Tulosarkisto";
-    const QString _filename = "data.json";
+    SkiResultStore _store;
+    SkiResultStore _staging;
+    mutable SkiResultIndex _index;
+    mutable SkiCareerIndex _careers;
+    SkiCareerIndex _stagingcareers;
+    mutable bool _indexbuilt;
+    mutable bool _careersbuilt;
+    QString _url;
+    const QString _filename = "data.skis";
+    const QString _jsonFilename = "data.json";
     QNetworkAccessManager* _manager;
+    SkiRequestScheduler* _scheduler;
+    QThreadPool* _parsepool;
     QString _postparameters[2];
+    const int _startyear = 1974;
+    const int _refreshyears = 2;
+    const int _getrequestid = 0;
+    QVector<int> _pendingyears;
+    QVector<int> _mergedyears;
+    QVector<int> _changedyears;
+    QHash<int, QSharedPointer<SkiPageParseJob>> _parsejobs;
     bool _anonymous;
+    bool _fullupdate;
     int _sentrequests;
     int _receivedrequests;
+    int _failedrequests;
 };
 
 #endif // SKIDATARETRIEVER_H
@@ -0,0 +1,223 @@
+#include "skiengine.h"
+
+#include <QEventLoop>
+
+SkiEngine::SkiEngine(bool anonymous) :
+    m_analyzer(new SkiAnalyzer(nullptr, anonymous)),
+    m_anonymous(anonymous)
+{}
+
+SkiEngine::~SkiEngine()
+{}
+
+bool SkiEngine::open()
+{
+    if(m_analyzer->retriever())
+        return true;
+
+    SkiAnalyzer *analyzer = m_analyzer.data();
+    return waitForData([analyzer](){
+        analyzer->run();
+    });
+}
+
+bool SkiEngine::refresh()
+{
+    SkiDataRetriever *retriever = openedAnalyzer()->retriever();
+    return waitForData([retriever](){
+        retriever->RefreshDataBase();
+    });
+}
+
+bool SkiEngine::importJson(const QString &filename)
+{
+    if(m_analyzer->retriever())
+        return m_analyzer->retriever()->ImportData(filename);
+
+    // The database file of the working directory is written without
+    // retrieving the old database first
+    SkiDataRetriever retriever(nullptr, m_anonymous);
+    return retriever.ImportData(filename);
+}
+
+bool SkiEngine::exportJson(const QString &filename)
+{
+    return openedAnalyzer()->retriever()->ExportData(filename);
+}
+
+void SkiEngine::setParallel(bool parallel)
+{
+    m_analyzer->setParallel(parallel);
+}
+
+const SkiResultStore &SkiEngine::store() const
+{
+    static const SkiResultStore empty;
+    if(!m_analyzer->retriever())
+        return empty;
+
+    return m_analyzer->retriever()->Store();
+}
+
+QVector<SkiResultSetPtr> SkiEngine::search(const QVector<QString> &params)
+{
+    // A search emits its results a year at a time
+    QVector<SkiResultSetPtr> results;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::searchResults, &context,
+                     [&results](SkiResultSetPtr block){
+        results.append(block);
+    });
+    waitForAnswer([analyzer, &params](){
+        analyzer->handleSearchRequest(params);
+    });
+    return results;
+}
+
+SkiEngine::Comparison SkiEngine::compare(const QVector<QString> &params)
+{
+    Comparison comparison;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::compareData, &context,
+                     [&comparison](QVector<QVector<QString>> rows, int view){
+        if(view == 1)
+            comparison.first += rows;
+        else
+            comparison.second += rows;
+    });
+    QObject::connect(analyzer, &SkiAnalyzer::compareNumberOfParticipants, &context,
+                     [&comparison](QPair<QString, QString> numbers){
+        comparison.participants = numbers;
+    });
+    waitForAnswer([analyzer, &params](){
+        analyzer->handleCompareRequest(params);
+    });
+    return comparison;
+}
+
+QVector<QString> SkiEngine::times(const QVector<QString> &params)
+{
+    QVector<QString> times;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::timesData, &context,
+                     [&times](QVector<QString> row){
+        times = row;
+    });
+    waitForAnswer([analyzer, &params](){
+        analyzer->handleTimesRequest(params);
+    });
+    return times;
+}
+
+QVector<QVector<QString>> SkiEngine::bestAthletes(const QVector<QString> &params)
+{
+    QVector<QVector<QString>> athletes;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::bestAthleteData, &context,
+                     [&athletes](QVector<QVector<QString>> rows){
+        athletes += rows;
+    });
+    waitForAnswer([analyzer, &params](){
+        analyzer->handleBestAthleteRequest(params);
+    });
+    return athletes;
+}
+
+QHash<QString, int> SkiEngine::nationalities(const QString &years)
+{
+    QHash<QString, int> nationalities;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::nationalityDistributionData, &context,
+                     [&nationalities](QHash<QString, int> row){
+        nationalities = row;
+    });
+    waitForAnswer([analyzer, &years](){
+        analyzer->handleCountriesRequest(years);
+    });
+    return nationalities;
+}
+
+QVector<QVector<QString>> SkiEngine::teams(const QVector<QString> &params)
+{
+    QVector<QVector<QString>> teams;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::teamsData, &context,
+                     [&teams](QVector<QVector<QString>> rows){
+        teams += rows;
+    });
+    waitForAnswer([analyzer, &params](){
+        analyzer->handleTeamsRequest(params);
+    });
+    return teams;
+}
+
+QVector<QString> SkiEngine::prediction(const QString &race)
+{
+    QVector<QString> prediction;
+    SkiAnalyzer *analyzer = openedAnalyzer();
+    QEventLoop context;
+    QObject::connect(analyzer, &SkiAnalyzer::predictionData, &context,
+                     [&prediction](QVector<QString> row){
+        prediction = row;
+    });
+    waitForAnswer([analyzer, &race](){
+        analyzer->handlePredictionRequest(race);
+    });
+    return prediction;
+}
+
+SkiAnalyzer *SkiEngine::openedAnalyzer()
+{
+    // A retrieval that failed for some years still leaves a usable database
+    open();
+    return m_analyzer.data();
+}
+
+bool SkiEngine::waitForData(const std::function<void()> &start)
+{
+    // Data read from a file is ready before start returns, retrievals from
+    // the archive finish in the event loop. Data that couldn't be saved
+    // counts as a failure.
+    bool finished = false;
+    int failed = 0;
+    bool saved = true;
+    QEventLoop loop;
+    QObject::connect(m_analyzer.data(), &SkiAnalyzer::saveFailed, &loop,
+                     [&saved](){
+        saved = false;
+    });
+    QObject::connect(m_analyzer.data(), &SkiAnalyzer::dataReady, &loop,
+                     [&finished, &failed, &loop](int progress, int total, int failures){
+        if(progress == 0 && total == 0){
+            finished = true;
+            failed = failures;
+            loop.quit();
+        }
+    });
+    start();
+    if(!finished)
+        loop.exec();
+    return failed == 0 && saved;
+}
+
+void SkiEngine::waitForAnswer(const std::function<void()> &request)
+{
+    // Searches continue in the event loop, the other requests are answered
+    // before the slot returns
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(m_analyzer.data(), &SkiAnalyzer::dataSent, &loop,
+                     [&finished, &loop](){
+        finished = true;
+        loop.quit();
+    });
+    request();
+    if(!finished)
+        loop.exec();
+}
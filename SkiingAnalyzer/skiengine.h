@@ -0,0 +1,119 @@
+#ifndef SKIENGINE_H
+#define SKIENGINE_H
+
+#include <QHash>
+#include <QPair>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+#include "skianalyzer.h"
+#include "skiresultset.h"
+
+/**
+ * @brief The SkiEngine class runs the analyses of SkiAnalyzer without a user
+ *        interface. Every query blocks until the analyzer has answered it and
+ *        returns the answer instead of emitting it, so the engine can be used
+ *        from plain C++ code such as command-line tools and batch jobs. The
+ *        parameters of the queries are the same as those of the handle*Request
+ *        slots of SkiAnalyzer. Queries, refresh and exportJson open the
+ *        engine first if open hasn't been called.
+ */
+class SkiEngine
+{
+public:
+    /**
+     * @brief The Comparison struct holds the answer to a compare query.
+     */
+    struct Comparison {
+        QVector<QVector<QString>> first;
+        QVector<QVector<QString>> second;
+        QPair<QString, QString>   participants;
+    };
+
+    /**
+     * @brief SkiEngine: Creates an engine
+     * @param anonymous: True to retrieve and keep anonymized results only
+     * @pre A QCoreApplication exists and the engine is used in its thread
+     */
+    explicit SkiEngine(bool anonymous = false);
+    ~SkiEngine();
+
+    /**
+     * @brief open: Loads the database of the working directory. If there is
+     *        no database, it is retrieved from the result archive.
+     * @return Boolean indicating if every year was loaded or retrieved
+     */
+    bool open();
+
+    /**
+     * @brief refresh: Retrieves the latest years from the result archive
+     * @return Boolean indicating if every requested year was retrieved and
+     *         the database file was saved
+     */
+    bool refresh();
+
+    /**
+     * @brief importJson: Replaces the database with a JSON file. Before open
+     *        is called, the file replaces the database file that open reads.
+     * @param filename: Filename of the JSON file
+     * @return Boolean indicating if the file was read and saved to the
+     *         database file
+     */
+    bool importJson(const QString &filename);
+
+    /**
+     * @brief exportJson: Writes the database to a JSON file
+     * @param filename: Filename of the JSON file
+     * @return Boolean indicating if exporting was successful
+     */
+    bool exportJson(const QString &filename);
+
+    /**
+     * @brief setParallel: Selects if the years are scanned on a thread pool
+     * @param parallel: True to scan the years in parallel
+     */
+    void setParallel(bool parallel);
+
+    /**
+     * @brief store: Returns the database
+     * @return Result store of the engine, empty if open hasn't been called
+     */
+    const SkiResultStore &store() const;
+
+    QVector<SkiResultSetPtr> search(const QVector<QString> &params);
+    Comparison compare(const QVector<QString> &params);
+    QVector<QString> times(const QVector<QString> &params);
+    QVector<QVector<QString>> bestAthletes(const QVector<QString> &params);
+    QHash<QString, int> nationalities(const QString &years);
+    QVector<QVector<QString>> teams(const QVector<QString> &params);
+    QVector<QString> prediction(const QString &race);
+
+private:
+    /**
+     * @brief openedAnalyzer: Returns the analyzer, opened if it wasn't
+     * @return Analyzer with a database
+     */
+    SkiAnalyzer *openedAnalyzer();
+
+    /**
+     * @brief waitForData: Runs a retrieval and waits until it has finished
+     * @param start: Function that starts the retrieval
+     * @return Boolean indicating if every year was retrieved and saved
+     */
+    bool waitForData(const std::function<void()> &start);
+
+    /**
+     * @brief waitForAnswer: Makes a request and waits until it has been
+     *        handled
+     * @param request: Function that calls a handle*Request slot
+     */
+    void waitForAnswer(const std::function<void()> &request);
+
+    QScopedPointer<SkiAnalyzer> m_analyzer;
+    bool                        m_anonymous;
+};
+
+#endif // SKIENGINE_H
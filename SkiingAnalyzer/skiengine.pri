@@ -0,0 +1,12 @@
+# Settings for building against the SkiingEngine library, which holds the
+# retrieval and the analyses without a user interface. Included by the
+# library itself and by every program linking it.
+
+QT       += core network concurrent
+
+# Tracing is built in with CONFIG+=ski_trace, see skitrace.h. The library
+# and the programs linking it must agree on it.
+ski_trace: DEFINES += SKI_TRACE
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
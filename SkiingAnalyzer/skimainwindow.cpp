@@ -5,6 +5,8 @@ Q_DECLARE_METATYPE(QVector<QString>);
 SkiMainWindow::SkiMainWindow(QWidget *parent): QMainWindow(parent)
 {
     qRegisterMetaType<QVector<QString>>();
+    qRegisterMetaType<QVector<QVector<QString>>>();
+    qRegisterMetaType<SkiResultSetPtr>();
     qRegisterMetaType<QHash<QString, int>>();
     qRegisterMetaType<QPair<QString,QString>>();
     setAttribute( Qt::WA_DeleteOnClose );
@@ -74,13 +76,22 @@ void SkiMainWindow::quitProgram()
     close();
 }
 
-void SkiMainWindow::retrieverDataReady(int progress, int total)
+void SkiMainWindow::retrieverDataReady(int progress, int total, int failed)
 {
     if (progress == 0 && total == 0) {
         // set the progress bar invisible if the loading is complete.
         m_barAct->setVisible(false);
         m_updateAct->setVisible(true);
+        m_fullUpdateAct->setVisible(true);
         m_dock->releaseAfterUpdate();
+
+        // Tell the user if some of the data couldn't be retrieved.
+        if (failed > 0) {
+            QMessageBox::warning(this, "Update failed",
+                                 QString("%1 years could not be retrieved. "
+                                         "The previous data was kept.")
+                                 .arg(failed));
+        }
     }
     else {
         m_bar->setMaximum(total);
@@ -88,14 +99,44 @@ void SkiMainWindow::retrieverDataReady(int progress, int total)
     }
 }
 
+void SkiMainWindow::retrieverSaveFailed(const QString &filename)
+{
+    QMessageBox::warning(this, "Saving failed",
+                         QString("The skiing data could not be saved to %1. "
+                                 "The retrieved data is used until the "
+                                 "program is closed.").arg(filename));
+}
+
+void SkiMainWindow::showCacheStatistics(int hits, int misses)
+{
+    statusBar()->showMessage(QString("Query cache: %1 hits, %2 misses")
+                             .arg(hits).arg(misses));
+}
+
+void SkiMainWindow::showSearchProgress(int progress, int total)
+{
+    statusBar()->showMessage(QString("Searched %1 of %2 years")
+                             .arg(progress).arg(total));
+}
+
 void SkiMainWindow::updateDataBaseClicked()
 {
     m_updateAct->setVisible(false);
+    m_fullUpdateAct->setVisible(false);
     m_barAct->setVisible(true);
     m_dock->lockForUpdate();
     emit refreshData();
 }
 
+void SkiMainWindow::fullUpdateClicked()
+{
+    m_updateAct->setVisible(false);
+    m_fullUpdateAct->setVisible(false);
+    m_barAct->setVisible(true);
+    m_dock->lockForUpdate();
+    emit updateData();
+}
+
 void SkiMainWindow::createAnalyzerThread()
 {
     QThread* thread = new QThread;
@@ -106,10 +147,15 @@ void SkiMainWindow::createAnalyzerThread()
     connect(this, &SkiMainWindow::stopThread, thread, &QThread::quit);
     connect(this, &SkiMainWindow::stopThread, m_analyzer, &SkiAnalyzer::deleteLater);
     connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-    connect(m_analyzer, &SkiAnalyzer::addNewRow, m_view, &SkiView::Addrow);
+    connect(m_analyzer, &SkiAnalyzer::searchResults, m_view, &SkiView::AddResults);
     connect(m_analyzer, &SkiAnalyzer::dataReady, this, &SkiMainWindow::retrieverDataReady);
+    connect(m_analyzer, &SkiAnalyzer::saveFailed, this, &SkiMainWindow::retrieverSaveFailed);
+    connect(m_analyzer, &SkiAnalyzer::queryCacheStatistics, this, &SkiMainWindow::showCacheStatistics);
 
     connect(m_dock, &SkiQuestionsDock::search, m_analyzer, &SkiAnalyzer::handleSearchRequest);
+    connect(m_dock, &SkiQuestionsDock::cancelSearch, m_analyzer, &SkiAnalyzer::cancelSearch);
+    connect(m_analyzer, &SkiAnalyzer::searchProgress, this, &SkiMainWindow::showSearchProgress);
+    connect(m_analyzer, &SkiAnalyzer::searchSuperseded, m_view, &SkiView::ClearView);
     connect(m_dock, &SkiQuestionsDock::compare, m_analyzer, &SkiAnalyzer::handleCompareRequest);
     connect(m_dock, &SkiQuestionsDock::getTimes, m_analyzer, &SkiAnalyzer::handleTimesRequest);
     connect(m_dock, &SkiQuestionsDock::getBest, m_analyzer, &SkiAnalyzer::handleBestAthleteRequest);
@@ -120,6 +166,7 @@ void SkiMainWindow::createAnalyzerThread()
     connect(m_analyzer, &SkiAnalyzer::dataSent, m_dock, &SkiQuestionsDock::releaseButtons);
     connect(m_analyzer, &SkiAnalyzer::dataSent, m_view, &SkiView::dataReady);
     connect(this, &SkiMainWindow::refreshData, m_analyzer, &SkiAnalyzer::refreshDataStorages);
+    connect(this, &SkiMainWindow::updateData, m_analyzer, &SkiAnalyzer::updateDataStorages);
 
     connect(m_analyzer, &SkiAnalyzer::compareData, m_view, &SkiView::showCompareData);
     connect(m_analyzer, &SkiAnalyzer::compareNumberOfParticipants, m_view, &SkiView::showCompareNumberOfParticipants);
@@ -152,6 +199,12 @@ void SkiMainWindow::createMenuAndToolBar()
     toolBar->addAction(m_updateAct);
     menu->addAction(m_updateAct);
 
+    // Refresh fetches only the latest years, a full update downloads every
+    // year again, for example if the old results have been corrected
+    m_fullUpdateAct = new QAction(updateIcon, tr("&Download all skiing data"), this);
+    connect(m_fullUpdateAct, &QAction::triggered, this, &SkiMainWindow::fullUpdateClicked);
+    menu->addAction(m_fullUpdateAct);
+
     const QIcon closeIcon = QIcon::fromTheme("document-new", QIcon(":/closelogo.png"));
     QAction *closeAct = new QAction(closeIcon, tr("&Close"), this);
     connect(closeAct, &QAction::triggered, this, &SkiMainWindow::quitProgram);
@@ -172,6 +225,7 @@ void SkiMainWindow::createMenuAndToolBar()
     m_barAct->setDefaultWidget(m_bar);
     toolBar->addAction(m_barAct);
     m_updateAct->setVisible(false);
+    m_fullUpdateAct->setVisible(false);
 }
 
 
@@ -8,6 +8,7 @@
 #include <QMenuBar>
 #include <QToolBar>
 #include <QMessageBox>
+#include <QStatusBar>
 
 #include "skiview.h"
 #include "skiquestionsdock.h"
@@ -44,10 +45,18 @@ public slots:
      *        updates the status of the UI's progress bar.
      * @param progress: amount of progress the SkiDataRetriever has done.
      * @param total: The max number of the progress integer.
+     * @param failed: Number of years the SkiDataRetriever couldn't retrieve.
      * @pre  Parameters are positive integers.
      * @post Progress bar has been updated.
      */
-    void retrieverDataReady(int progress, int total);
+    void retrieverDataReady(int progress, int total, int failed);
+
+    /**
+     * @brief retrieverSaveFailed slot is invoked by SkiDataRetriever when the
+     *        retrieved data couldn't be saved. The slot warns the user.
+     * @param filename: the filename of the database file.
+     */
+    void retrieverSaveFailed(const QString &filename);
 
     /**
      * @brief updateDataBaseClicked slot is invoked when update button is
@@ -57,6 +66,33 @@ public slots:
      */
     void updateDataBaseClicked();
 
+    /**
+     * @brief fullUpdateClicked slot is invoked when the full update action is
+     *        triggered. The slot orders the SkiDataRetriever to download the
+     *        data of every year again.
+     * @post Signal has been emitted.
+     */
+    void fullUpdateClicked();
+
+    /**
+     * @brief showCacheStatistics slot is invoked by SkiAnalyzer after each
+     *        request. The slot shows how many requests were answered from
+     *        the query cache in the status bar.
+     * @param hits: the number of requests answered from the cache.
+     * @param misses: the number of requests that were analysed.
+     * @post Status bar has been updated.
+     */
+    void showCacheStatistics(int hits, int misses);
+
+    /**
+     * @brief showSearchProgress slot is invoked by SkiAnalyzer after each
+     *        searched year. The slot shows the progress in the status bar.
+     * @param progress: the number of searched years.
+     * @param total: the number of years to search.
+     * @post Status bar has been updated.
+     */
+    void showSearchProgress(int progress, int total);
+
 signals:
     /**
      * @brief stopThread signal stops the thread that runs SkiAnalyzer.
@@ -69,6 +105,12 @@ signals:
      */
     void refreshData();
 
+    /**
+     * @brief updateData signal orders the SkiDataRetriever to replace its
+     *        databases with the data of every year.
+     */
+    void updateData();
+
     /**
      * @brief saveTimesChart signal tells the SkiView to save the current time
      *        development chart as png.
@@ -101,6 +143,7 @@ private:
     QProgressBar*     m_bar;
     QWidgetAction*    m_barAct;
     QAction*          m_updateAct;
+    QAction*          m_fullUpdateAct;
     bool              m_anonymous;
 };
 
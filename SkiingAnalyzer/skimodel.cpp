@@ -1,7 +1,22 @@
 #include "skimodel.h"
+#include "skiresultstore.h"
+#include "skitrace.h"
+
+#include <QCollator>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Number of search results shown at a time
+const int FetchSize = 500;
+
+}
 
 SkiModel::SkiModel(QObject *parent)
-    : QAbstractItemModel(parent)
+    : QAbstractItemModel(parent), m_visible(0), m_resultCount(0)
 {
 }
 
@@ -13,6 +28,11 @@ QVariant SkiModel::headerData(int section, Qt::Orientation orientation, int role
     return m_columns.at(section);
 }
 
+void SkiModel::setColumnTypes(const QVector<ColumnType> &types)
+{
+    m_columnTypes = types;
+}
+
 void SkiModel::SetColumns(QVector<QString> &columns)
 {
     layoutAboutToBeChanged();
@@ -30,7 +50,7 @@ int SkiModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    return m_data.size();
+    return m_visible;
 }
 
 int SkiModel::columnCount(const QModelIndex &parent) const
@@ -44,68 +64,174 @@ int SkiModel::columnCount(const QModelIndex &parent) const
 QVariant SkiModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid()) return QVariant();
-    if (index.row() > m_data.size()) return QVariant();
-    if (index.column() > m_columns.size()) return QVariant();
+    if (index.row() >= m_visible) return QVariant();
+    if (index.column() >= m_columns.size()) return QVariant();
 
     if (role == Qt::DisplayRole) {
-        return m_data.at(index.row()).at(index.column());
+        return sourceText(m_order.at(index.row()), index.column());
     }
     return QVariant();
 }
 
+bool SkiModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+    return m_visible < m_order.size();
+}
+
+void SkiModel::fetchMore(const QModelIndex &parent)
+{
+    SKI_TRACE_SPAN("model", "fetch");
+    if (parent.isValid()) return;
+
+    const int count = qMin(FetchSize, m_order.size() - m_visible);
+    if (count <= 0) return;
+
+    beginInsertRows(QModelIndex(), m_visible, m_visible + count - 1);
+    m_visible += count;
+    endInsertRows();
+}
+
 void SkiModel::clearData()
 {
-    layoutAboutToBeChanged();
+    beginResetModel();
 
     m_data.clear();
+    m_order.clear();
+    m_results.clear();
+    m_resultStarts.clear();
+    m_visible = 0;
+    m_resultCount = 0;
 
-    layoutChanged();
+    endResetModel();
 }
 
 void SkiModel::sort(int column, Qt::SortOrder order)
 {
-    if (m_sortableColumns.contains(column)) {
-        if (order == Qt::AscendingOrder) {
-            QVector<QVector<QString>> newData = QVector<QVector<QString>>();
-
-            for (auto row : m_data) {
-                if (newData.isEmpty()) newData.append(row);
-                else {
-                    for (int i = 0; i < newData.size(); ++i) {
-                        if (row[column] <= newData[i][column]) {
-                            newData.insert(i, row);
-                            break;
-                        }
-                        else if (i == newData.size() - 1) {
-                            newData.append(row);
-                            break;
-                        }
-                    }
-                }
-            }
-            m_data = newData;
+    SKI_TRACE_SPAN("model", "sort");
+    if (!m_sortableColumns.contains(column)) return;
+    if (column < 0 || column >= m_columns.size()) return;
+
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(),
+                                QAbstractItemModel::VerticalSortHint);
+
+    // Sort keys are made once per row so that comparing two rows is cheap.
+    // Positions of the current order are sorted, so rows that have not been
+    // fetched yet are sorted too.
+    QVector<int> positions(m_order.size());
+    for (int i = 0; i < positions.size(); ++i) {
+        positions[i] = i;
+    }
+    const ColumnType type = column < m_columnTypes.size() ? m_columnTypes.at(column)
+                                                          : TextColumn;
+
+    if (type == TextColumn) {
+        QCollator collator;
+        collator.setCaseSensitivity(Qt::CaseInsensitive);
+
+        QVector<QCollatorSortKey> keys;
+        keys.reserve(m_order.size());
+        for (int source : m_order) {
+            keys.append(collator.sortKey(sourceText(source, column)));
         }
-        else if (order == Qt::DescendingOrder) {
-            QVector<QVector<QString>> newData = QVector<QVector<QString>>();
-
-            for (auto row : m_data) {
-                if (newData.isEmpty()) newData.append(row);
-                else {
-                    for (int i = 0; i < newData.size(); ++i) {
-                        if (row[column] >= newData[i][column]) {
-                            newData.insert(i, row);
-                            break;
-                        }
-                        else if (i == newData.size() - 1) {
-                            newData.append(row);
-                            break;
-                        }
-                    }
-                }
-            }
-            m_data = newData;
+
+        std::stable_sort(positions.begin(), positions.end(), [&](int a, int b) {
+            if (order == Qt::AscendingOrder) return keys.at(a).compare(keys.at(b)) < 0;
+            return keys.at(b).compare(keys.at(a)) < 0;
+        });
+    }
+    else {
+        // Values that are not available get NaN and are put last.
+        QVector<double> keys;
+        keys.reserve(m_order.size());
+        for (int source : m_order) {
+            keys.append(sourceKey(type, source, column));
         }
+
+        std::stable_sort(positions.begin(), positions.end(), [&](int a, int b) {
+            const bool aMissing = std::isnan(keys.at(a));
+            const bool bMissing = std::isnan(keys.at(b));
+            if (aMissing || bMissing) return !aMissing && bMissing;
+            if (order == Qt::AscendingOrder) return keys.at(a) < keys.at(b);
+            return keys.at(b) < keys.at(a);
+        });
+    }
+
+    // Move the persistent indexes of the views to the new rows. Rows that
+    // are moved past the fetched rows lose their indexes.
+    QVector<int> newOrder(m_order.size());
+    QVector<int> newRows(m_order.size());
+    for (int row = 0; row < positions.size(); ++row) {
+        newOrder[row] = m_order.at(positions.at(row));
+        newRows[positions.at(row)] = row;
+    }
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (const QModelIndex &index : oldIndexes) {
+        const int row = newRows.at(index.row());
+        if (row < m_visible) newIndexes.append(createIndex(row, index.column()));
+        else newIndexes.append(QModelIndex());
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    m_order = newOrder;
+
+    emit layoutChanged(QList<QPersistentModelIndex>(),
+                       QAbstractItemModel::VerticalSortHint);
+}
+
+double SkiModel::numericKey(ColumnType type, const QString &value) const
+{
+    bool ok = false;
+    double key = 0;
+
+    if (type == IntegerColumn) {
+        key = value.toLongLong(&ok);
+    }
+    else if (type == DecimalColumn) {
+        key = value.toDouble(&ok);
+    }
+    else if (type == TimeColumn) {
+        const qint32 time = SkiResultStore::parseTime(value.toUtf8());
+        ok = time != SkiResultStore::NoTime;
+        key = time;
+    }
+
+    return ok ? key : std::numeric_limits<double>::quiet_NaN();
+}
+
+double SkiModel::sourceKey(ColumnType type, int source, int column) const
+{
+    if (source >= 0) {
+        return numericKey(type, m_data.at(source).at(column));
     }
+
+    // Search results are sorted by the values of the store without
+    // formatting them.
+    const int result = -source - 1;
+    const int set = resultSet(result);
+    return m_results.at(set)->sortKey(result - m_resultStarts.at(set), column);
+}
+
+QString SkiModel::sourceText(int source, int column) const
+{
+    if (source >= 0) {
+        return m_data.at(source).at(column);
+    }
+
+    // Search results are formatted only when they are shown.
+    const int result = -source - 1;
+    const int set = resultSet(result);
+    return m_results.at(set)->text(result - m_resultStarts.at(set), column);
+}
+
+int SkiModel::resultSet(int result) const
+{
+    return static_cast<int>(std::upper_bound(m_resultStarts.constBegin(),
+                                             m_resultStarts.constEnd(), result)
+                            - m_resultStarts.constBegin()) - 1;
 }
 
 QModelIndex SkiModel::index(int row, int column, const QModelIndex &) const
@@ -120,10 +246,57 @@ QModelIndex SkiModel::parent(const QModelIndex &) const
 
 void SkiModel::AddRow(QVector<QString> row)
 {
+    SKI_TRACE_SPAN("model", "add row");
     if (row.size() != m_columns.size()) return;
-    layoutAboutToBeChanged();
+    beginInsertRows(QModelIndex(), m_visible, m_visible);
+    m_order.insert(m_visible, m_data.size());
     m_data.append(row);
-    layoutChanged();
+    ++m_visible;
+    endInsertRows();
+}
+
+void SkiModel::AddRows(QVector<QVector<QString>> rows)
+{
+    SKI_TRACE_SPAN("model", "add rows");
+    SKI_TRACE_VALUE("model.rows", rows.size());
+
+    // Rows that don't fit the columns are dropped before the insertion.
+    QVector<QVector<QString>> validRows;
+    validRows.reserve(rows.size());
+    for (const QVector<QString> &row : rows) {
+        if (row.size() == m_columns.size()) validRows.append(row);
+    }
+    if (validRows.isEmpty()) return;
+
+    beginInsertRows(QModelIndex(), m_visible, m_visible + validRows.size() - 1);
+    m_order.insert(m_visible, validRows.size(), 0);
+    for (int i = 0; i < validRows.size(); ++i) {
+        m_order[m_visible + i] = m_data.size() + i;
+    }
+    m_data += validRows;
+    m_visible += validRows.size();
+    endInsertRows();
+}
+
+void SkiModel::AddResults(SkiResultSetPtr results)
+{
+    SKI_TRACE_SPAN("model", "add results");
+    if (!results || results->size() == 0) return;
+    if (m_columns.size() != SkiResultSet::ColumnCount) return;
+
+    // Only a handle to the results is kept. The rows are shown when the
+    // view fetches them.
+    m_resultStarts.append(m_resultCount);
+    m_results.append(results);
+    for (int i = 0; i < results->size(); ++i) {
+        m_order.append(-(m_resultCount + i) - 1);
+    }
+    m_resultCount += results->size();
+
+    // The first page is shown at once.
+    if (m_visible < FetchSize) {
+        fetchMore(QModelIndex());
+    }
 }
 
 void SkiModel::setSortableColumns(QVector<int> indexes)
@@ -3,9 +3,14 @@
 
 #include <QAbstractItemModel>
 
+#include "skiresultset.h"
+
 /**
  * @brief The SkiModel class is inherited from QAbstractItemModel. It works
- *        as a model for the QtreeViews of the UI.
+ *        as a model for the QtreeViews of the UI. Rows are either added as
+ *        formatted strings or as search result sets. Result sets are only
+ *        referenced, their rows are fetched a page at a time as the view
+ *        scrolls and their cells are formatted when they are shown.
  */
 class SkiModel : public QAbstractItemModel
 {
@@ -21,6 +26,25 @@ public slots:
      */
     void AddRow(QVector<QString> row);
 
+    /**
+     * @brief AddRows slot adds a block of rows to the m_data vector with a
+     *        single insertion.
+     * @param rows: the rows of data to be added.
+     * @pre  Every row has a value for every column.
+     * @post Valid rows have been added.
+     */
+    void AddRows(QVector<QVector<QString>> rows);
+
+    /**
+     * @brief AddResults slot adds search results to the model. The first
+     *        page of the results is shown at once and the rest when the view
+     *        fetches more.
+     * @param results: the results to be added.
+     * @pre  Model has the columns of a result set.
+     * @post Results have been added.
+     */
+    void AddResults(SkiResultSetPtr results);
+
     /**
      * @brief setSortableColumns slot saves the indexes of columns that can be
      *        sorted
@@ -31,8 +55,26 @@ public slots:
     void setSortableColumns(QVector<int> indexes);
 
 public:
+    /**
+     * @brief The ColumnType enum tells how the values of a column are
+     *        compared when the model is sorted.
+     */
+    enum ColumnType {
+        TextColumn,     // locale-aware text
+        IntegerColumn,  // ranking, year
+        DecimalColumn,  // average speed
+        TimeColumn      // h:mm:ss.cc
+    };
+
     explicit SkiModel(QObject *parent = nullptr);
 
+    /**
+     * @brief setColumnTypes method saves the types of the columns.
+     * @param types: type of every column, columns without a type are text.
+     * @post Parameter has been saved.
+     */
+    void setColumnTypes(const QVector<ColumnType> &types);
+
     /**
      * @brief headerData method sends header data to the QtreeView this model
      *        is attached to.
@@ -82,6 +124,21 @@ public:
      */
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    /**
+     * @brief canFetchMore method tells if there are results that are not
+     *        shown yet.
+     * @param parent: check QT documentation for more info.
+     * @return true if more rows can be fetched.
+     */
+    bool canFetchMore(const QModelIndex &parent) const override;
+
+    /**
+     * @brief fetchMore method shows the next page of results.
+     * @param parent: check QT documentation for more info.
+     * @post more rows are shown.
+     */
+    void fetchMore(const QModelIndex &parent) override;
+
     /**
      * @brief clearData method clears the models data structure.
      * @post data has been removed.
@@ -90,7 +147,10 @@ public:
 
     /**
      * @brief sort method sorts the models data according to the given
-     *        parameters.
+     *        parameters. Only the order of the rows is sorted, the rows
+     *        themselves are not moved. Sorting is stable, so rows with equal
+     *        values keep the order of the previous sort, and values that are
+     *        not available are always last.
      * @param column: the column to sort by.
      * @param order: ascending or descending.
      * @pre  parameter column is valid and can be found from sortable columns.
@@ -119,9 +179,53 @@ public:
 
 private:
 
+    /**
+     * @brief numericKey method converts a value of a numeric column to a
+     *        sort key.
+     * @param type: type of the column.
+     * @param value: the value to convert.
+     * @return the sort key, NaN if the value is not available.
+     */
+    double numericKey(ColumnType type, const QString &value) const;
+
+    /**
+     * @brief sourceKey method returns the sort key of a numeric cell of a row
+     *        in the order the rows were added. Keys of search results are
+     *        read from the store, added rows are converted from text.
+     * @param type: type of the column.
+     * @param source: row in m_data if not negative, otherwise -1 - index of
+     *        the row in the result sets.
+     * @param column: the column of the cell.
+     * @return the sort key, NaN if the value is not available.
+     */
+    double sourceKey(ColumnType type, int source, int column) const;
+
+    /**
+     * @brief sourceText method returns a cell of a row in the order the rows
+     *        were added.
+     * @param source: row in m_data if not negative, otherwise -1 - index of
+     *        the row in the result sets.
+     * @param column: the column of the cell.
+     * @return the cell as text.
+     */
+    QString sourceText(int source, int column) const;
+
+    /**
+     * @brief resultSet method finds the result set of a search result.
+     * @param result: index of the row in the result sets.
+     * @return index of the result set in m_results.
+     */
+    int resultSet(int result) const;
+
     QVector<QString>            m_columns;
+    QVector<ColumnType>         m_columnTypes;
     QVector<QVector<QString>>   m_data;
+    QVector<SkiResultSetPtr>    m_results;
+    QVector<int>                m_resultStarts;
+    QVector<int>                m_order;
     QVector<int>                m_sortableColumns;
+    int                         m_visible;
+    int                         m_resultCount;
 };
 
 #endif // SKIMODEL_H
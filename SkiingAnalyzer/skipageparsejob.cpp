@@ -0,0 +1,62 @@
+#include "skipageparsejob.h"
+#include "skitrace.h"
+
+#include <QtConcurrent>
+
+SkiPageParseJob::SkiPageParseJob(QThreadPool *pool, Handler handler) :
+    m_pool(pool),
+    m_handler(handler),
+    m_running(false),
+    m_finished(false)
+{}
+
+void SkiPageParseJob::append(const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    m_chunks.enqueue(data);
+    schedule();
+}
+
+void SkiPageParseJob::finish(const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    m_chunks.enqueue(data);
+    m_finished = true;
+    schedule();
+}
+
+void SkiPageParseJob::schedule()
+{
+    if(m_running)
+        return;
+
+    // The worker keeps the job alive until the queue is empty
+    m_running = true;
+    QSharedPointer<SkiPageParseJob> job = sharedFromThis();
+    QtConcurrent::run(m_pool, [job](){
+        job->drain();
+    });
+}
+
+void SkiPageParseJob::drain()
+{
+    forever{
+        QByteArray data;
+        {
+            QMutexLocker locker(&m_mutex);
+            if(m_chunks.isEmpty()){
+                m_running = false;
+                if(!m_finished)
+                    return;
+                break;
+            }
+            data = m_chunks.dequeue();
+        }
+        SKI_TRACE_SPAN("parse", "feed");
+        m_parser.feed(data);
+    }
+
+    // Only one worker gets here, because finish is called once and the
+    // queue is empty
+    m_handler(m_parser);
+}
@@ -0,0 +1,72 @@
+#ifndef SKIPAGEPARSEJOB_H
+#define SKIPAGEPARSEJOB_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <functional>
+
+#include "skiresultpageparser.h"
+
+/**
+ * @brief The SkiPageParseJob class parses one downloaded result page on a
+ *        thread pool. Chunks of the page are queued as they arrive and a
+ *        worker parses them in order, so pages of different years are parsed
+ *        in parallel. When the whole page has been parsed, the handler is
+ *        called in the worker thread.
+ */
+class SkiPageParseJob : public QEnableSharedFromThis<SkiPageParseJob>
+{
+public:
+    /**
+     * @brief Handler: Function called in the worker thread with the parser
+     *        after the last chunk has been parsed
+     */
+    typedef std::function<void(SkiResultPageParser &parser)> Handler;
+
+    /**
+     * @brief SkiPageParseJob: Constructor
+     * @param pool: Thread pool that runs the parsing
+     * @param handler: Function called when the page has been parsed
+     * @pre Pool outlives the job
+     */
+    SkiPageParseJob(QThreadPool *pool, Handler handler);
+
+    /**
+     * @brief append: Queues the next chunk of the page for parsing
+     * @param data: Bytes of the page
+     */
+    void append(const QByteArray &data);
+
+    /**
+     * @brief finish: Queues the last chunk of the page
+     * @param data: Remaining bytes of the page
+     * @post Handler is called once the queued chunks have been parsed
+     */
+    void finish(const QByteArray &data);
+
+private:
+    /**
+     * @brief schedule: Starts a worker if no worker is parsing the job
+     * @pre Mutex is locked
+     */
+    void schedule();
+
+    /**
+     * @brief drain: Parses the queued chunks in a worker thread
+     */
+    void drain();
+
+    QThreadPool        *m_pool;
+    Handler             m_handler;
+    QMutex              m_mutex;
+    QQueue<QByteArray>  m_chunks;
+    bool                m_running;
+    bool                m_finished;
+    SkiResultPageParser m_parser;
+};
+
+#endif // SKIPAGEPARSEJOB_H
@@ -0,0 +1,177 @@
+#include "skiquerycache.h"
+#include "skitrace.h"
+
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+
+// Rough size of the bookkeeping of a string or a container
+const int ObjectOverhead = 24;
+
+}
+
+SkiQueryCache::SkiQueryCache(int budget) :
+    m_entries(budget),
+    m_hits(0),
+    m_misses(0)
+{}
+
+QString SkiQueryCache::key(const QString &type, const QVector<QString> &params)
+{
+    QStringList parts;
+    parts << type;
+    for(const QString &param : params)
+        parts << param.trimmed().toLower();
+
+    // Unit separator can't be typed to the parameter fields
+    return parts.join(QChar(0x1f));
+}
+
+bool SkiQueryCache::find(const QString &key, QVariant &value)
+{
+    const QVariant *entry = m_entries.object(key);
+    if(!entry){
+        SKI_TRACE_COUNT("cache.misses", 1);
+        ++m_misses;
+        return false;
+    }
+
+    SKI_TRACE_COUNT("cache.hits", 1);
+    ++m_hits;
+    value = *entry;
+    return true;
+}
+
+void SkiQueryCache::insert(const QString &key, const QVariant &value, int cost,
+                           int firstYear, int lastYear)
+{
+    // QCache takes the ownership and deletes the entry if it doesn't fit
+    if(!m_entries.insert(key, new QVariant(value), qMax(1, cost))){
+        m_years.remove(key);
+        return;
+    }
+    m_years.insert(key, qMakePair(qMin(firstYear, lastYear),
+                                  qMax(firstYear, lastYear)));
+
+    // Years of dropped results are kept only until there are as many of them
+    // as there are results
+    if(m_years.size() > 2 * m_entries.count())
+        pruneYears();
+}
+
+void SkiQueryCache::invalidateYears(const QVector<int> &years)
+{
+    if(years.isEmpty())
+        return;
+
+    // Years are kept apart from the results, so looking them up doesn't
+    // change the order in which the results are dropped
+    for(auto it = m_years.begin(); it != m_years.end();){
+        const QPair<int, int> range = it.value();
+        const bool changed = std::any_of(years.constBegin(), years.constEnd(),
+                                         [range](int year){
+            return year >= range.first && year <= range.second;
+        });
+        if(changed || !m_entries.contains(it.key())){
+            m_entries.remove(it.key());
+            it = m_years.erase(it);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+void SkiQueryCache::invalidateType(const QString &type)
+{
+    const QString prefix = type + QChar(0x1f);
+    for(const QString &key : m_entries.keys()){
+        if(key.startsWith(prefix)){
+            m_entries.remove(key);
+            m_years.remove(key);
+        }
+    }
+}
+
+void SkiQueryCache::clear()
+{
+    m_entries.clear();
+    m_years.clear();
+}
+
+void SkiQueryCache::setBudget(int budget)
+{
+    m_entries.setMaxCost(budget);
+}
+
+int SkiQueryCache::budget() const
+{
+    return m_entries.maxCost();
+}
+
+int SkiQueryCache::cost() const
+{
+    return m_entries.totalCost();
+}
+
+int SkiQueryCache::count() const
+{
+    return m_entries.count();
+}
+
+int SkiQueryCache::hits() const
+{
+    return m_hits;
+}
+
+int SkiQueryCache::misses() const
+{
+    return m_misses;
+}
+
+void SkiQueryCache::pruneYears()
+{
+    for(auto it = m_years.begin(); it != m_years.end();){
+        if(m_entries.contains(it.key()))
+            ++it;
+        else
+            it = m_years.erase(it);
+    }
+}
+
+int SkiQueryCache::costOf(const QVector<QString> &value)
+{
+    int cost = ObjectOverhead;
+    for(const QString &text : value)
+        cost += ObjectOverhead + text.size() * static_cast<int>(sizeof(QChar));
+    return cost;
+}
+
+int SkiQueryCache::costOf(const QVector<QVector<QString>> &value)
+{
+    int cost = ObjectOverhead;
+    for(const QVector<QString> &row : value)
+        cost += costOf(row);
+    return cost;
+}
+
+int SkiQueryCache::costOf(const QHash<QString, int> &value)
+{
+    int cost = ObjectOverhead;
+    for(auto it = value.constBegin(); it != value.constEnd(); ++it)
+        cost += 2 * ObjectOverhead + it.key().size() * static_cast<int>(sizeof(QChar));
+    return cost;
+}
+
+int SkiQueryCache::costOf(const QVector<SkiResultSetPtr> &value)
+{
+    // Result sets keep a copy of the store, which shares the columns of the
+    // current store. Search results are dropped when the store is replaced,
+    // so that old columns aren't kept alive, and only the rows are their own.
+    int cost = ObjectOverhead;
+    for(const SkiResultSetPtr &results : value)
+        cost += ObjectOverhead + results->size() * static_cast<int>(sizeof(int));
+    return cost;
+}
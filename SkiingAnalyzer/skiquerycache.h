@@ -0,0 +1,113 @@
+#ifndef SKIQUERYCACHE_H
+#define SKIQUERYCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "skiresultset.h"
+
+/**
+ * @brief The SkiQueryCache class keeps the results of recent analyses so
+ *        that a repeated request is answered without scanning the store.
+ *        Results are keyed by the request type and its normalized
+ *        parameters. Every result tells the years it was calculated from,
+ *        and it is dropped when the data of any of those years changes. The
+ *        least recently used results are dropped when the estimated memory
+ *        use of the results exceeds the budget.
+ */
+class SkiQueryCache
+{
+public:
+    /**
+     * @brief SkiQueryCache: Creates an empty cache
+     * @param budget: Memory budget in bytes
+     */
+    explicit SkiQueryCache(int budget = 64 * 1024 * 1024);
+
+    /**
+     * @brief key: Makes the key of a request
+     * @param type: Type of the request, for example "search"
+     * @param params: Parameters of the request
+     * @return Key in which the parameters are trimmed and in lower case
+     */
+    static QString key(const QString &type, const QVector<QString> &params);
+
+    /**
+     * @brief find: Finds the result of a request and marks it recently used
+     * @param key: Key of the request
+     * @param value: Object to which the result is copied
+     * @return True if the result was found
+     */
+    bool find(const QString &key, QVariant &value);
+
+    /**
+     * @brief insert: Adds the result of a request
+     * @param key: Key of the request
+     * @param value: Result of the request
+     * @param cost: Estimated size of the result in bytes
+     * @param firstYear: First year the result depends on
+     * @param lastYear: Last year the result depends on
+     * @post Least recently used results are dropped to keep within the
+     *       budget. A result larger than the budget is not kept.
+     */
+    void insert(const QString &key, const QVariant &value, int cost,
+                int firstYear, int lastYear);
+
+    /**
+     * @brief invalidateYears: Drops the results that depend on any of the
+     *        given years
+     * @param years: Years whose data has changed
+     */
+    void invalidateYears(const QVector<int> &years);
+
+    /**
+     * @brief invalidateType: Drops every result of a request type
+     * @param type: Type of the requests, for example "search"
+     */
+    void invalidateType(const QString &type);
+
+    /**
+     * @brief clear: Drops every result
+     */
+    void clear();
+
+    /**
+     * @brief setBudget: Sets the memory budget
+     * @param budget: Memory budget in bytes
+     */
+    void setBudget(int budget);
+
+    int budget() const;
+    int cost() const;
+    int count() const;
+    int hits() const;
+    int misses() const;
+
+    /**
+     * @brief costOf: Estimates the memory use of a result
+     * @param value: Result
+     * @return Size in bytes
+     */
+    static int costOf(const QVector<QString> &value);
+    static int costOf(const QVector<QVector<QString>> &value);
+    static int costOf(const QHash<QString, int> &value);
+    static int costOf(const QVector<SkiResultSetPtr> &value);
+
+private:
+    /**
+     * @brief pruneYears: Forgets the years of the results that QCache has
+     *        dropped
+     */
+    void pruneYears();
+
+    QCache<QString, QVariant>       m_entries;
+    QHash<QString, QPair<int, int>> m_years;
+    int                             m_hits;
+    int                             m_misses;
+};
+
+#endif // SKIQUERYCACHE_H
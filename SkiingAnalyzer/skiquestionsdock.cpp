@@ -16,6 +16,7 @@ SkiQuestionsDock::SkiQuestionsDock(QWidget *parent) :
     connect(ui->u_clearTeams, &QPushButton::clicked, this, &SkiQuestionsDock::clearTeams);
 
     connect(ui->u_searchButton, &QPushButton::clicked, this, &SkiQuestionsDock::searchClicked);
+    connect(ui->u_stopButton, &QPushButton::clicked, this, &SkiQuestionsDock::cancelSearch);
     connect(ui->u_compareButton, &QPushButton::clicked, this, &SkiQuestionsDock::compareClicked);
     connect(ui->u_getTimes, &QPushButton::clicked, this, &SkiQuestionsDock::timesClicked);
     connect(ui->u_getBest, &QPushButton::clicked, this, &SkiQuestionsDock::getBestClicked);
@@ -55,6 +56,10 @@ void SkiQuestionsDock::searchClicked()
                             << QString(ui->u_toTime->currentText());
     emit search(params);
     lockButtons();
+
+    // A running search can be stopped or replaced by a new search
+    ui->u_searchButton->setDisabled(false);
+    ui->u_stopButton->setDisabled(false);
 }
 
 void SkiQuestionsDock::compareClicked()
@@ -110,7 +115,9 @@ void SkiQuestionsDock::getTeamsClicked()
 {
     QVector<QString> params = QVector<QString>()
                           << QString(ui->u_teamsYear->currentText())
-                          << QString(ui->u_teamsType->currentText());
+                          << QString(ui->u_teamsType->currentText())
+                          << QString::number(ui->u_teamsCount->value())
+                          << QString::number(ui->u_teamSize->value());
     emit getTeams(params);
     lockButtons();
 }
@@ -233,6 +240,7 @@ void SkiQuestionsDock::getDistYear(QString &year)
 void SkiQuestionsDock::releaseButtons(int)
 {
     ui->u_searchButton->setDisabled(false);
+    ui->u_stopButton->setDisabled(true);
     ui->u_compareButton->setDisabled(false);
     ui->u_getTimes->setDisabled(false);
     ui->u_getBest->setDisabled(false);
@@ -106,6 +106,11 @@ signals:
      */
     void search(const QVector<QString> &params);
 
+    /**
+     * @brief cancelSearch signal stops the running search in SkiAnalyzer.
+     */
+    void cancelSearch();
+
     /**
      * @brief compare signal sends compare parameters to SkiAnalyzer.
      * @param params includes the needed parameters given by the user.
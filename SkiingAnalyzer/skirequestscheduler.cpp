@@ -0,0 +1,108 @@
+#include "skirequestscheduler.h"
+
+namespace {
+
+// Delay before the first retry of a request. The delay doubles for every
+// retry up to the longest delay.
+const int InitialBackoff = 1000;
+const int MaxBackoff = 16000;
+
+// Doubling stops here, long before the delay could overflow
+const int MaxBackoffShift = 30;
+
+}
+
+SkiRequestScheduler::SkiRequestScheduler(QObject *parent) :
+    QObject(parent),
+    m_maxInFlight(4),
+    m_timeout(30000),
+    m_maxRetries(3)
+{}
+
+void SkiRequestScheduler::enqueue(int id, RequestFactory request)
+{
+    Job job;
+    job.id = id;
+    job.request = request;
+    job.attempts = 0;
+    m_queue.enqueue(job);
+
+    startNext();
+}
+
+void SkiRequestScheduler::setMaxInFlight(int count)
+{
+    m_maxInFlight = qMax(1, count);
+    startNext();
+}
+
+void SkiRequestScheduler::setTimeout(int msecs)
+{
+    m_timeout = qMax(0, msecs);
+}
+
+void SkiRequestScheduler::setMaxRetries(int retries)
+{
+    m_maxRetries = qMax(0, retries);
+}
+
+void SkiRequestScheduler::startNext()
+{
+    while(m_running.size() < m_maxInFlight && !m_queue.isEmpty()){
+        Job job = m_queue.dequeue();
+        ++job.attempts;
+
+        QNetworkReply *reply = job.request();
+        m_running.insert(reply, job);
+
+        // Abort the request if nothing arrives for too long. Every arriving
+        // chunk restarts the timer, so a large page may take longer as long
+        // as it keeps coming. Aborting finishes the reply with an error, so
+        // it is retried like any failed request.
+        if(m_timeout > 0){
+            QTimer *timer = new QTimer(reply);
+            timer->setSingleShot(true);
+            connect(timer, &QTimer::timeout, reply, &QNetworkReply::abort);
+            connect(reply, &QNetworkReply::uploadProgress, timer,
+                    static_cast<void (QTimer::*)()>(&QTimer::start));
+            connect(reply, &QNetworkReply::downloadProgress, timer,
+                    static_cast<void (QTimer::*)()>(&QTimer::start));
+            timer->start(m_timeout);
+        }
+
+        connect(reply, &QNetworkReply::finished, this, [this, reply](){
+            handleFinished(reply);
+        });
+
+        emit requestStarted(job.id, reply);
+    }
+}
+
+void SkiRequestScheduler::handleFinished(QNetworkReply *reply)
+{
+    if(!m_running.contains(reply))
+        return;
+
+    const Job job = m_running.take(reply);
+
+    if(reply->error() == QNetworkReply::NoError){
+        emit replyReady(job.id, reply);
+    }
+    else if(job.attempts <= m_maxRetries){
+        // Wait longer before every retry
+        const int shift = qMin(job.attempts - 1, MaxBackoffShift);
+        const qint64 delay = qMin<qint64>(static_cast<qint64>(InitialBackoff) << shift,
+                                          MaxBackoff);
+
+        QTimer::singleShot(static_cast<int>(delay), this, [this, job](){
+            m_queue.prepend(job);
+            startNext();
+        });
+    }
+    else{
+        emit requestFailed(job.id, reply->errorString());
+    }
+
+    reply->deleteLater();
+    startNext();
+}
@@ -0,0 +1,114 @@
+#ifndef SKIREQUESTSCHEDULER_H
+#define SKIREQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QNetworkReply>
+#include <QQueue>
+#include <QHash>
+#include <QTimer>
+
+#include <functional>
+
+/**
+ * @brief The SkiRequestScheduler class runs network requests with a limited
+ *        number of requests in flight. A request that receives nothing for
+ *        longer than the timeout is aborted, and failed or aborted requests
+ *        are retried with exponential backoff.
+ *        Requests that still fail after the last retry are reported with
+ *        requestFailed.
+ */
+class SkiRequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief RequestFactory: Function that starts a request and returns its
+     *        reply. It is called again for every retry.
+     */
+    typedef std::function<QNetworkReply *()> RequestFactory;
+
+    explicit SkiRequestScheduler(QObject *parent = nullptr);
+
+    /**
+     * @brief enqueue: Adds a request to the queue
+     * @param id: Id of the request used in the signals
+     * @param request: Function that starts the request
+     * @post Request is started when there is room for it
+     */
+    void enqueue(int id, RequestFactory request);
+
+    /**
+     * @brief setMaxInFlight: Sets the number of requests run at the same time
+     * @param count: Number of requests, at least 1
+     */
+    void setMaxInFlight(int count);
+
+    /**
+     * @brief setTimeout: Sets how long a request may go without receiving
+     *        data before it is aborted. A slow page that is still arriving
+     *        is not aborted.
+     * @param msecs: Timeout in milliseconds, 0 disables the timeout
+     */
+    void setTimeout(int msecs);
+
+    /**
+     * @brief setMaxRetries: Sets how many times a failed request is retried
+     * @param retries: Number of retries
+     */
+    void setMaxRetries(int retries);
+
+signals:
+    /**
+     * @brief requestStarted: Notifies that a request or its retry has been
+     *        started
+     * @param id: Id of the request
+     * @param reply: Reply of the request
+     */
+    void requestStarted(int id, QNetworkReply *reply);
+
+    /**
+     * @brief replyReady: Notifies that a request has succeeded. The reply is
+     *        deleted after the signal has been handled.
+     * @param id: Id of the request
+     * @param reply: Reply of the request
+     */
+    void replyReady(int id, QNetworkReply *reply);
+
+    /**
+     * @brief requestFailed: Notifies that a request has failed after all
+     *        retries
+     * @param id: Id of the request
+     * @param error: Description of the last error
+     */
+    void requestFailed(int id, const QString &error);
+
+private:
+    /**
+     * @brief The Job struct holds a queued request.
+     */
+    struct Job {
+        int            id;
+        RequestFactory request;
+        int            attempts;
+    };
+
+    /**
+     * @brief startNext: Starts queued requests while there is room for them
+     */
+    void startNext();
+
+    /**
+     * @brief handleFinished: Handles a finished reply and retries it if it
+     *        failed
+     * @param reply: Finished reply
+     */
+    void handleFinished(QNetworkReply *reply);
+
+    QQueue<Job>                 m_queue;
+    QHash<QNetworkReply *, Job> m_running;
+    int                         m_maxInFlight;
+    int                         m_timeout;
+    int                         m_maxRetries;
+};
+
+#endif // SKIREQUESTSCHEDULER_H
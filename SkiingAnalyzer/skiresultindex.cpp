@@ -0,0 +1,124 @@
+#include "skiresultindex.h"
+
+#include <QStringList>
+
+SkiResultIndex::SkiResultIndex()
+{}
+
+void SkiResultIndex::build(const SkiResultStore &store)
+{
+    buildKey(LastName, store, SkiResultStore::Name);
+    buildKey(FirstName, store, SkiResultStore::Name);
+    buildKey(Team, store, SkiResultStore::Team);
+    buildKey(Nationality, store, SkiResultStore::Nationality);
+    buildKey(Locality, store, SkiResultStore::Locality);
+}
+
+void SkiResultIndex::clear()
+{
+    for(Postings &postings : m_postings)
+        postings = Postings();
+}
+
+SkiResultIndex::RowRange SkiResultIndex::rows(Key key, const QString &value) const
+{
+    const Postings &postings = m_postings[key];
+    const int i = postings.values.value(normalize(value), -1);
+    if(i == -1)
+        return RowRange();
+
+    // The list is not copied, broad values have millions of rows
+    const int begin = postings.starts.at(i);
+    return RowRange(postings.rows.constData() + begin,
+                    postings.starts.at(i + 1) - begin);
+}
+
+QVector<int> SkiResultIndex::intersect(const RowRange &a, const RowRange &b)
+{
+    QVector<int> common;
+    common.reserve(qMin(a.size, b.size));
+
+    int i = 0;
+    int j = 0;
+    while(i < a.size && j < b.size){
+        if(a.data[i] < b.data[j]){
+            ++i;
+        }
+        else if(b.data[j] < a.data[i]){
+            ++j;
+        }
+        else{
+            common.append(a.data[i]);
+            ++i;
+            ++j;
+        }
+    }
+    return common;
+}
+
+QString SkiResultIndex::normalize(const QString &value)
+{
+    return value.toLower();
+}
+
+QVector<QString> SkiResultIndex::splitName(const QString &name)
+{
+    const QStringList list = name.split(" ");
+    QVector<QString> parts;
+
+    if(list.length() == 2){
+        parts << list[0] << list[1];
+    }
+    // in case of incomplete data or typo:
+    else{
+        parts << list[0] << "";
+    }
+    return parts;
+}
+
+void SkiResultIndex::buildKey(Key key, const SkiResultStore &store,
+                              SkiResultStore::Field field)
+{
+    Postings postings;
+
+    // Every dictionary entry is normalized once. Entries with the same
+    // normalized value share a posting list.
+    const SkiStringDictionary &dictionary = store.dictionary(field);
+    QVector<int> valueOfId(dictionary.size());
+    for(int id = 0; id < dictionary.size(); ++id){
+        const QString value = keyValue(key, dictionary.text(id));
+        int i = postings.values.value(value, -1);
+        if(i == -1){
+            i = postings.values.size();
+            postings.values.insert(value, i);
+        }
+        valueOfId[id] = i;
+    }
+
+    // Rows are counted per value and then placed in row order, so every
+    // posting list is sorted without sorting
+    postings.starts.fill(0, postings.values.size() + 1);
+    for(int row = 0; row < store.size(); ++row)
+        ++postings.starts[valueOfId.at(store.idAt(field, row)) + 1];
+    for(int i = 1; i < postings.starts.size(); ++i)
+        postings.starts[i] += postings.starts.at(i - 1);
+
+    QVector<int> next = postings.starts;
+    postings.rows.resize(store.size());
+    for(int row = 0; row < store.size(); ++row)
+        postings.rows[next[valueOfId.at(store.idAt(field, row))]++] = row;
+
+    m_postings[key] = postings;
+}
+
+QString SkiResultIndex::keyValue(Key key, const QString &text)
+{
+    switch(key){
+    case LastName:
+        return normalize(splitName(text)[0]);
+    case FirstName:
+        return normalize(splitName(text)[1]);
+    default:
+        return normalize(text);
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef SKIRESULTINDEX_H
+#define SKIRESULTINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiResultIndex class maps normalized values of the searchable
+ *        text fields to the rows of a result store that have the value. The
+ *        rows of a value form a posting list in ascending row order, so the
+ *        rows of a year or a race are a continuous part of every list and
+ *        the lists of several conditions can be intersected in one pass.
+ *        Values are normalized once per distinct dictionary entry when the
+ *        index is built.
+ */
+class SkiResultIndex
+{
+public:
+    /**
+     * @brief The Key enum lists the indexed values.
+     */
+    enum Key {
+        LastName = 0,
+        FirstName,
+        Team,
+        Nationality,
+        Locality,
+        KeyCount
+    };
+
+    /**
+     * @brief The RowRange struct is a read-only view of rows in ascending
+     *        order. A range returned by rows points into the index and is
+     *        valid until the index is rebuilt or cleared.
+     */
+    struct RowRange {
+        RowRange() : data(nullptr), size(0) {}
+        RowRange(const int *rows, int count) : data(rows), size(count) {}
+        explicit RowRange(const QVector<int> &rows) :
+            data(rows.constData()), size(rows.size()) {}
+
+        /**
+         * @brief toVector: Copies the rows
+         * @return Rows in ascending order
+         */
+        QVector<int> toVector() const
+        {
+            QVector<int> rows(size);
+            std::copy(data, data + size, rows.begin());
+            return rows;
+        }
+
+        const int *data;
+        int        size;
+    };
+
+    SkiResultIndex();
+
+    /**
+     * @brief build: Indexes every row of a store
+     * @param store: Store to index
+     * @post Old index is replaced. Row numbers refer to the given store and
+     *       the index must be rebuilt when the store changes.
+     */
+    void build(const SkiResultStore &store);
+
+    /**
+     * @brief clear: Removes every posting list
+     */
+    void clear();
+
+    /**
+     * @brief rows: Returns the rows that have a value
+     * @param key: Indexed value
+     * @param value: Value to look up, normalized before the lookup
+     * @return View of the posting list, empty if the value is not found
+     */
+    RowRange rows(Key key, const QString &value) const;
+
+    /**
+     * @brief intersect: Returns the rows found in both posting lists
+     * @param a: Rows in ascending order
+     * @param b: Rows in ascending order
+     * @return Common rows in ascending order
+     */
+    static QVector<int> intersect(const RowRange &a, const RowRange &b);
+
+    /**
+     * @brief normalize: Returns the form of a value used as an index key
+     * @param value: Value as it is stored or typed by the user
+     * @return Value in lower case
+     */
+    static QString normalize(const QString &value);
+
+    /**
+     * @brief splitName: Splits the name of an athlete to last and first name
+     * @param name: Name in "Last First" form
+     * @return Last and first name. If the name doesn't have exactly two
+     *         parts, the first part and an empty first name.
+     */
+    static QVector<QString> splitName(const QString &name);
+
+private:
+    /**
+     * @brief The Postings struct holds the posting lists of one key. The
+     *        list of a value is m_rows[starts[i]..starts[i + 1]) where i is
+     *        the index of the value in values.
+     */
+    struct Postings {
+        QHash<QString, int> values;
+        QVector<int>        starts;
+        QVector<int>        rows;
+    };
+
+    /**
+     * @brief buildKey: Builds the posting lists of one key
+     * @param key: Indexed value
+     * @param store: Store to index
+     * @param field: Text field the value is taken from
+     */
+    void buildKey(Key key, const SkiResultStore &store,
+                  SkiResultStore::Field field);
+
+    /**
+     * @brief keyValue: Returns the index key of a dictionary entry
+     * @param key: Indexed value
+     * @param text: Text of the dictionary entry
+     * @return Normalized value
+     */
+    static QString keyValue(Key key, const QString &text);
+
+    Postings m_postings[KeyCount];
+};
+
+#endif // SKIRESULTINDEX_H
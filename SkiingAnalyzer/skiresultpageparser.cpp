@@ -0,0 +1,146 @@
+#include "skiresultpageparser.h"
+
+namespace {
+
+const QByteArray YearId    = "dnn_ctr1025_Etusivu_ddlVuosi2x";
+const QByteArray Selected  = "selected=";
+const QByteArray RowId     = "dnn_ctr1025_Etusivu_dgrTulokset_ctl00__";
+const QByteArray CellStart = "<td";
+const QByteArray InfoStart = ">";
+const QByteArray Empty     = "&nbsp;";
+const char       InfoEnd   = '<';
+
+}
+
+SkiResultPageParser::SkiResultPageParser()
+{
+    reset();
+}
+
+void SkiResultPageParser::reset()
+{
+    m_state = FindYear;
+    m_buffer.clear();
+    m_text.clear();
+    m_year = 0;
+    m_field = 0;
+    m_record = SkiResultStore::RawRecord();
+    m_records.clear();
+}
+
+void SkiResultPageParser::feed(const QByteArray &data)
+{
+    m_buffer.append(data);
+
+    int pos = 0;
+    while(step(pos)) {}
+
+    // Only the bytes that may continue in the next chunk are kept
+    m_buffer.remove(0, pos);
+}
+
+int SkiResultPageParser::year() const
+{
+    return m_year;
+}
+
+QVector<SkiResultStore::RawRecord> SkiResultPageParser::takeRecords()
+{
+    QVector<SkiResultStore::RawRecord> records;
+    records.swap(m_records);
+    return records;
+}
+
+bool SkiResultPageParser::step(int &pos)
+{
+    switch(m_state){
+    case FindYear:
+        if(!skipTo(YearId, pos))
+            return false;
+        m_state = FindSelectedYear;
+        return true;
+
+    case FindSelectedYear:
+        if(!skipTo(Selected, pos))
+            return false;
+        m_state = FindYearText;
+        return true;
+
+    case FindYearText:
+        if(!skipTo(InfoStart, pos))
+            return false;
+        m_state = ReadYearText;
+        return true;
+
+    case ReadYearText:
+        if(!readText(pos))
+            return false;
+        m_year = m_text.trimmed().toInt();
+        m_text.clear();
+        m_state = FindRow;
+        return true;
+
+    case FindRow:
+        if(!skipTo(RowId, pos))
+            return false;
+        m_field = 0;
+        m_state = FindCell;
+        return true;
+
+    case FindCell:
+        if(!skipTo(CellStart, pos))
+            return false;
+        m_state = FindCellText;
+        return true;
+
+    case FindCellText:
+        if(!skipTo(InfoStart, pos))
+            return false;
+        m_state = ReadCellText;
+        return true;
+
+    case ReadCellText:
+        if(!readText(pos))
+            return false;
+
+        if(m_text == Empty)
+            m_text.clear();
+        m_record.cells[m_field] = m_text;
+        m_text.clear();
+
+        // Row is complete after the last cell
+        if(++m_field == SkiResultStore::FieldCount){
+            m_records.append(m_record);
+            m_state = FindRow;
+        }
+        else{
+            m_state = FindCell;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool SkiResultPageParser::skipTo(const QByteArray &pattern, int &pos)
+{
+    const int index = m_buffer.indexOf(pattern, pos);
+    if(index == -1){
+        pos = qMax(pos, m_buffer.size() - pattern.size() + 1);
+        return false;
+    }
+
+    pos = index + pattern.size();
+    return true;
+}
+
+bool SkiResultPageParser::readText(int &pos)
+{
+    const int index = m_buffer.indexOf(InfoEnd, pos);
+    const int end = index == -1 ? m_buffer.size() : index;
+
+    m_text.append(m_buffer.constData() + pos, end - pos);
+    pos = end;
+
+    return index != -1;
+}
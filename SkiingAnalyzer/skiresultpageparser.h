@@ -0,0 +1,89 @@
+#ifndef SKIRESULTPAGEPARSER_H
+#define SKIRESULTPAGEPARSER_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiResultPageParser class parses a result page of Finlandia
+ *        hiihto while it is being downloaded. The page is fed in chunks of
+ *        UTF-8 bytes as they arrive and only the unparsed end of the latest
+ *        chunk is buffered. The parser finds the selected year of the page
+ *        and the cells of every row of the result table.
+ */
+class SkiResultPageParser
+{
+public:
+    SkiResultPageParser();
+
+    /**
+     * @brief reset: Clears the parser for a new page
+     */
+    void reset();
+
+    /**
+     * @brief feed: Parses the next chunk of the page
+     * @param data: Bytes of the page following the previous chunk
+     */
+    void feed(const QByteArray &data);
+
+    /**
+     * @brief year: Returns the year selected on the page
+     * @return Year of the page or 0 if it hasn't been found
+     */
+    int year() const;
+
+    /**
+     * @brief takeRecords: Returns the rows parsed so far and removes them
+     *        from the parser
+     * @return Parsed rows
+     */
+    QVector<SkiResultStore::RawRecord> takeRecords();
+
+private:
+    enum State {
+        FindYear,
+        FindSelectedYear,
+        FindYearText,
+        ReadYearText,
+        FindRow,
+        FindCell,
+        FindCellText,
+        ReadCellText
+    };
+
+    /**
+     * @brief step: Advances the parser by one state
+     * @param pos: Position in the buffer, moved past the parsed bytes
+     * @return False if more data is needed
+     */
+    bool step(int &pos);
+
+    /**
+     * @brief skipTo: Skips the buffer past the next occurrence of a pattern
+     * @param pattern: Pattern to find
+     * @param pos: Position in the buffer
+     * @return False if the pattern isn't in the buffer yet. The end of the
+     *         buffer that may begin the pattern is then left unparsed.
+     */
+    bool skipTo(const QByteArray &pattern, int &pos);
+
+    /**
+     * @brief readText: Reads text until the beginning of the next tag
+     * @param pos: Position in the buffer
+     * @return False if the text continues in the next chunk
+     */
+    bool readText(int &pos);
+
+    State                              m_state;
+    QByteArray                         m_buffer;
+    QByteArray                         m_text;
+    int                                m_year;
+    int                                m_field;
+    SkiResultStore::RawRecord          m_record;
+    QVector<SkiResultStore::RawRecord> m_records;
+};
+
+#endif // SKIRESULTPAGEPARSER_H
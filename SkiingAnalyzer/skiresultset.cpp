@@ -0,0 +1,123 @@
+#include "skiresultset.h"
+
+#include <limits>
+
+SkiResultSet::SkiResultSet(const SkiResultStore &store, const QVector<int> &rows) :
+    m_store(store),
+    m_rows(rows)
+{}
+
+int SkiResultSet::size() const
+{
+    return m_rows.size();
+}
+
+QString SkiResultSet::text(int i, int column) const
+{
+    if(i < 0 || i >= m_rows.size())
+        return QString();
+
+    return cell(m_store, m_rows.at(i), column);
+}
+
+double SkiResultSet::sortKey(int i, int column) const
+{
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    if(i < 0 || i >= m_rows.size())
+        return missing;
+
+    const int row = m_rows.at(i);
+    switch(column){
+    case YearColumn:
+        return m_store.yearAt(row);
+    case TimeColumn: {
+        const qint32 time = m_store.timeAt(row);
+        return time == SkiResultStore::NoTime ? missing : time;
+    }
+    case RankingColumn: {
+        const qint32 placement = m_store.placementAt(row);
+        return placement > 0 ? placement : missing;
+    }
+    case BirthYearColumn: {
+        bool ok = false;
+        const int year = m_store.dictionary(SkiResultStore::BirthYear)
+                                .utf8(m_store.birthYearAt(row)).toInt(&ok);
+        return ok ? year : missing;
+    }
+    case SpeedColumn: {
+        const qint32 time = m_store.timeAt(row);
+        if(time == SkiResultStore::NoTime || time <= 0)
+            return missing;
+        return distance(m_store, row) / (time / (60.0 * 60.0 * 100.0));
+    }
+    default:
+        return missing;
+    }
+}
+
+QString SkiResultSet::cell(const SkiResultStore &store, int row, int column)
+{
+    switch(column){
+    case YearColumn:
+        return store.text(SkiResultStore::Year, row);
+    case TypeColumn:
+        return store.text(SkiResultStore::Distance, row);
+    case TimeColumn:
+        return store.text(SkiResultStore::Time, row);
+    case RankingColumn:
+        return store.text(SkiResultStore::Placement, row);
+    case GenderColumn:
+        return store.text(SkiResultStore::Sex, row);
+    case NameColumn:
+        return store.text(SkiResultStore::Name, row);
+    case LocalityColumn:
+        return store.text(SkiResultStore::Locality, row);
+    case NationalityColumn:
+        return store.text(SkiResultStore::Nationality, row);
+    case BirthYearColumn:
+        return store.text(SkiResultStore::BirthYear, row);
+    case TeamColumn:
+        return store.text(SkiResultStore::Team, row);
+    case SpeedColumn:
+        return averageSpeed(store, row);
+    default:
+        return QString();
+    }
+}
+
+QVector<QString> SkiResultSet::formatRow(const SkiResultStore &store, int row)
+{
+    QVector<QString> cells;
+    cells.reserve(ColumnCount);
+    for(int column = 0; column < ColumnCount; ++column)
+        cells.append(cell(store, row, column));
+    return cells;
+}
+
+QString SkiResultSet::averageSpeed(const SkiResultStore &store, int row)
+{
+    const qint32 time = store.timeAt(row);
+    if(time == SkiResultStore::NoTime || time <= 0)
+        return "not available";
+
+    const float hours = time / (60.0f * 60.0f * 100.0f);
+    QString speed = QString::number(distance(store, row) / hours);
+
+    // rounding average speed to 2 decimals
+    const int pos = speed.lastIndexOf(QChar('.'));
+    if(pos != -1)
+        speed = speed.left(pos + 3);
+
+    return speed;
+}
+
+float SkiResultSet::distance(const SkiResultStore &store, int row)
+{
+    // Distance is the number in the race code, for example 50 in P50
+    QString digits;
+    for(QChar c : store.text(SkiResultStore::Distance, row)){
+        if(c.isDigit())
+            digits.append(c);
+    }
+    return digits.toFloat();
+}
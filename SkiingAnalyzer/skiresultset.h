@@ -0,0 +1,114 @@
+#ifndef SKIRESULTSET_H
+#define SKIRESULTSET_H
+
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiResultSet class is an immutable list of rows of a result
+ *        store. It keeps its own copy of the store, which shares the columns
+ *        with the original, so it can be read in another thread while the
+ *        original store is updated. Cells are formatted to text only when
+ *        they are asked for.
+ */
+class SkiResultSet
+{
+public:
+    /**
+     * @brief The Column enum lists the columns of a result row as they are
+     *        shown in the result views.
+     */
+    enum Column {
+        YearColumn = 0,
+        TypeColumn,
+        TimeColumn,
+        RankingColumn,
+        GenderColumn,
+        NameColumn,
+        LocalityColumn,
+        NationalityColumn,
+        BirthYearColumn,
+        TeamColumn,
+        SpeedColumn,
+        ColumnCount
+    };
+
+    /**
+     * @brief SkiResultSet: Constructor
+     * @param store: Store the rows belong to
+     * @param rows: Rows in the store
+     */
+    SkiResultSet(const SkiResultStore &store, const QVector<int> &rows);
+
+    /**
+     * @brief size: Returns the number of rows
+     * @return Number of rows
+     */
+    int size() const;
+
+    /**
+     * @brief text: Formats one cell of a row
+     * @param i: Row in the set
+     * @param column: Column of the cell
+     * @return Cell as it is shown to the user
+     */
+    QString text(int i, int column) const;
+
+    /**
+     * @brief sortKey: Returns the value of a numeric cell of a row straight
+     *        from the columns of the store
+     * @param i: Row in the set
+     * @param column: One of YearColumn, TimeColumn, RankingColumn,
+     *        BirthYearColumn or SpeedColumn
+     * @return Value of the cell, NaN if it is not available or the column
+     *         is not numeric
+     */
+    double sortKey(int i, int column) const;
+
+    /**
+     * @brief cell: Formats one cell of a row of a store
+     * @param store: Result store
+     * @param row: Row in the store
+     * @param column: Column of the cell
+     * @return Cell as it is shown to the user
+     */
+    static QString cell(const SkiResultStore &store, int row, int column);
+
+    /**
+     * @brief formatRow: Formats every cell of a row of a store
+     * @param store: Result store
+     * @param row: Row in the store
+     * @return Cells of the row in column order
+     */
+    static QVector<QString> formatRow(const SkiResultStore &store, int row);
+
+private:
+    /**
+     * @brief averageSpeed: Formats the average speed of a row in km/h
+     * @param store: Result store
+     * @param row: Row in the store
+     * @return Speed rounded down to two decimals or "not available"
+     */
+    static QString averageSpeed(const SkiResultStore &store, int row);
+
+    /**
+     * @brief distance: Reads the length of the race of a row
+     * @param store: Result store
+     * @param row: Row in the store
+     * @return Kilometres in the race code, for example 50 in P50
+     */
+    static float distance(const SkiResultStore &store, int row);
+
+    SkiResultStore m_store;
+    QVector<int>   m_rows;
+};
+
+typedef QSharedPointer<const SkiResultSet> SkiResultSetPtr;
+
+Q_DECLARE_METATYPE(SkiResultSetPtr)
+
+#endif // SKIRESULTSET_H
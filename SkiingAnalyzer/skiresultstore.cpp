@@ -0,0 +1,526 @@
+#include "skiresultstore.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <limits>
+
+const char SkiResultStore::RedactedText[] = "[Redacted]";
+
+SkiResultStore::SkiResultStore() :
+    m_anonymous(false)
+{}
+
+void SkiResultStore::clear()
+{
+    m_races.clear();
+    m_yearInfos.clear();
+    for(int i = 0; i < FieldCount; ++i)
+        m_dictionaries[i].clear();
+
+    m_years.clear();
+    m_distances.clear();
+    m_times.clear();
+    m_timeFormats.clear();
+    m_placements.clear();
+    m_placementsMale.clear();
+    m_placementsFemale.clear();
+    m_sexes.clear();
+    m_names.clear();
+    m_localities.clear();
+    m_nationalities.clear();
+    m_birthYears.clear();
+    m_teams.clear();
+    m_mappedFile.clear();
+    m_fileBuffer.clear();
+}
+
+void SkiResultStore::detach()
+{
+    for(int i = 0; i < FieldCount; ++i)
+        m_dictionaries[i].detach();
+
+    m_years.detach();
+    m_distances.detach();
+    m_times.detach();
+    m_timeFormats.detach();
+    m_placements.detach();
+    m_placementsMale.detach();
+    m_placementsFemale.detach();
+    m_sexes.detach();
+    m_names.detach();
+    m_localities.detach();
+    m_nationalities.detach();
+    m_birthYears.detach();
+    m_teams.detach();
+    m_mappedFile.clear();
+    m_fileBuffer.clear();
+}
+
+bool SkiResultStore::isMapped() const
+{
+    for(int i = 0; i < FieldCount; ++i){
+        if(m_dictionaries[i].isMapped())
+            return true;
+    }
+
+    return m_years.isMapped() || m_distances.isMapped() || m_times.isMapped()
+            || m_timeFormats.isMapped() || m_placements.isMapped() || m_placementsMale.isMapped()
+            || m_placementsFemale.isMapped() || m_sexes.isMapped()
+            || m_names.isMapped() || m_localities.isMapped()
+            || m_nationalities.isMapped() || m_birthYears.isMapped()
+            || m_teams.isMapped();
+}
+
+bool SkiResultStore::setYear(int year, const QVector<RawRecord> &records)
+{
+    // Group records by distance while keeping the order of the page inside
+    // each distance. Distances and sexes have narrow columns, so a year
+    // whose ids don't fit them is rejected before any column is modified.
+    QVector<quint16> distanceOrder;
+    QHash<quint16, QVector<int>> groups;
+    for(int i = 0; i < records.size(); ++i){
+        const quint32 id = m_dictionaries[Distance].intern(records[i].cells[Distance]);
+        if(id > std::numeric_limits<quint16>::max())
+            return false;
+
+        const quint16 distance = static_cast<quint16>(id);
+        if(!groups.contains(distance))
+            distanceOrder.append(distance);
+        groups[distance].append(i);
+    }
+
+    const int count = records.size();
+    QVector<qint16> years(count, static_cast<qint16>(year));
+    QVector<quint16> distances;
+    QVector<qint32> times;
+    QVector<quint8> timeFormats;
+    QVector<qint32> placements;
+    QVector<qint32> placementsMale;
+    QVector<qint32> placementsFemale;
+    QVector<quint8> sexes;
+    QVector<quint32> names;
+    QVector<quint32> localities;
+    QVector<quint32> nationalities;
+    QVector<quint32> birthYears;
+    QVector<quint32> teams;
+
+    distances.reserve(count);
+    times.reserve(count);
+    timeFormats.reserve(count);
+    placements.reserve(count);
+    placementsMale.reserve(count);
+    placementsFemale.reserve(count);
+    sexes.reserve(count);
+    names.reserve(count);
+    localities.reserve(count);
+    nationalities.reserve(count);
+    birthYears.reserve(count);
+    teams.reserve(count);
+
+    int first = 0;
+    int last = 0;
+    yearRange(year, first, last);
+
+    const int begin = first < m_races.size() ? m_races[first].begin : size();
+    const int oldCount = first < last ? m_races[last - 1].end - begin : 0;
+
+    QVector<Race> races;
+    int row = begin;
+
+    for(quint16 distance : distanceOrder){
+        const QVector<int> &indexes = groups[distance];
+
+        Race race;
+        race.year = static_cast<qint16>(year);
+        race.distance = distance;
+        race.begin = row;
+        race.end = row + indexes.size();
+        races.append(race);
+        row = race.end;
+
+        for(int index : indexes){
+            const QByteArray *cells = records[index].cells;
+            distances.append(distance);
+            quint8 timeFormat = 0;
+            times.append(parseTime(cells[Time], &timeFormat));
+            timeFormats.append(timeFormat);
+            placements.append(parsePlacement(cells[Placement]));
+            placementsMale.append(parsePlacement(cells[PlacementMale]));
+            placementsFemale.append(parsePlacement(cells[PlacementFemale]));
+            const quint32 sex = m_dictionaries[Sex].intern(cells[Sex]);
+            if(sex > std::numeric_limits<quint8>::max())
+                return false;
+            sexes.append(static_cast<quint8>(sex));
+            names.append(m_dictionaries[Name].intern(cells[Name]));
+            localities.append(m_dictionaries[Locality].intern(cells[Locality]));
+            nationalities.append(
+                        m_dictionaries[Nationality].intern(cells[Nationality]));
+            birthYears.append(m_dictionaries[BirthYear].intern(cells[BirthYear]));
+            teams.append(m_dictionaries[Team].intern(cells[Team]));
+        }
+    }
+
+    m_years.splice(begin, oldCount, years);
+    m_distances.splice(begin, oldCount, distances);
+    m_times.splice(begin, oldCount, times);
+    m_timeFormats.splice(begin, oldCount, timeFormats);
+    m_placements.splice(begin, oldCount, placements);
+    m_placementsMale.splice(begin, oldCount, placementsMale);
+    m_placementsFemale.splice(begin, oldCount, placementsFemale);
+    m_sexes.splice(begin, oldCount, sexes);
+    m_names.splice(begin, oldCount, names);
+    m_localities.splice(begin, oldCount, localities);
+    m_nationalities.splice(begin, oldCount, nationalities);
+    m_birthYears.splice(begin, oldCount, birthYears);
+    m_teams.splice(begin, oldCount, teams);
+
+    // Move the rows of the following years
+    const int shift = count - oldCount;
+    for(int i = last; i < m_races.size(); ++i){
+        m_races[i].begin += shift;
+        m_races[i].end += shift;
+    }
+    m_races.remove(first, last - first);
+    for(int i = 0; i < races.size(); ++i)
+        m_races.insert(first + i, races[i]);
+
+    // Dictionaries without new strings keep reading the mapped file. Saving
+    // never overwrites a snapshot file, every save writes a new one, so the
+    // mapping stays valid until the last column or dictionary is copied.
+    if(!isMapped()){
+        m_mappedFile.clear();
+        m_fileBuffer.clear();
+    }
+    return true;
+}
+
+void SkiResultStore::removeYear(int year)
+{
+    setYear(year, QVector<RawRecord>());
+}
+
+bool SkiResultStore::yearInfo(int year, YearInfo &info) const
+{
+    for(const YearInfo &yearInfo : m_yearInfos){
+        if(yearInfo.year == year){
+            info = yearInfo;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SkiResultStore::setYearInfo(const YearInfo &info)
+{
+    // Information is kept ordered by year
+    int i = 0;
+    while(i < m_yearInfos.size() && m_yearInfos[i].year < info.year)
+        ++i;
+
+    if(i < m_yearInfos.size() && m_yearInfos[i].year == info.year)
+        m_yearInfos[i] = info;
+    else
+        m_yearInfos.insert(i, info);
+}
+
+quint64 SkiResultStore::contentHash(const QVector<RawRecord> &records)
+{
+    // 64-bit FNV-1a over every cell, cells are separated with a unit
+    // separator byte
+    quint64 hash = 14695981039346656037ULL;
+    for(const RawRecord &record : records){
+        for(int field = 0; field < FieldCount; ++field){
+            for(const char c : record.cells[field]){
+                hash ^= static_cast<quint8>(c);
+                hash *= 1099511628211ULL;
+            }
+            hash ^= 0x1f;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+bool SkiResultStore::containsYear(int year) const
+{
+    int first = 0;
+    int last = 0;
+    yearRange(year, first, last);
+    return first < last;
+}
+
+QVector<int> SkiResultStore::years() const
+{
+    QVector<int> years;
+    for(const Race &race : m_races){
+        if(years.isEmpty() || years.last() != race.year)
+            years.append(race.year);
+    }
+    return years;
+}
+
+int SkiResultStore::size() const
+{
+    return m_years.size();
+}
+
+bool SkiResultStore::isAnonymous() const
+{
+    return m_anonymous;
+}
+
+void SkiResultStore::setAnonymous(bool anonymous)
+{
+    m_anonymous = anonymous;
+}
+
+SkiResultView SkiResultStore::all() const
+{
+    return SkiResultView(this, 0, size());
+}
+
+SkiResultView SkiResultStore::year(int year) const
+{
+    int first = 0;
+    int last = 0;
+    yearRange(year, first, last);
+
+    if(first == last)
+        return SkiResultView();
+
+    return SkiResultView(this, m_races[first].begin, m_races[last - 1].end);
+}
+
+SkiResultView SkiResultStore::race(int year, const QString &distance) const
+{
+    const qint64 id = m_dictionaries[Distance].find(distance.toUtf8());
+    if(id < 0)
+        return SkiResultView();
+
+    int first = 0;
+    int last = 0;
+    yearRange(year, first, last);
+
+    for(int i = first; i < last; ++i){
+        if(m_races[i].distance == id)
+            return SkiResultView(this, m_races[i].begin, m_races[i].end);
+    }
+    return SkiResultView();
+}
+
+QVector<SkiResultView> SkiResultStore::races(int year) const
+{
+    int first = 0;
+    int last = 0;
+    yearRange(year, first, last);
+
+    QVector<SkiResultView> races;
+    for(int i = first; i < last; ++i)
+        races.append(SkiResultView(this, m_races[i].begin, m_races[i].end));
+
+    return races;
+}
+
+const SkiStringDictionary &SkiResultStore::dictionary(Field field) const
+{
+    return m_dictionaries[field];
+}
+
+QString SkiResultStore::text(Field field, int row) const
+{
+    switch(field){
+    case Year:
+        return QString::number(m_years.at(row));
+    case Time:
+        return formatTime(m_times.at(row), m_timeFormats.at(row));
+    case Placement:
+    case PlacementMale:
+    case PlacementFemale: {
+        const qint32 placement = field == Placement ? m_placements.at(row)
+                               : field == PlacementMale ? m_placementsMale.at(row)
+                               : m_placementsFemale.at(row);
+        if(placement == RedactedPlacement)
+            return QString::fromLatin1(RedactedText);
+        return placement > 0 ? QString::number(placement) : QString();
+    }
+    case FieldCount:
+        return QString();
+    default:
+        return m_dictionaries[field].text(idAt(field, row));
+    }
+}
+
+quint32 SkiResultStore::idAt(Field field, int row) const
+{
+    switch(field){
+    case Distance:
+        return m_distances.at(row);
+    case Sex:
+        return m_sexes.at(row);
+    case Name:
+        return m_names.at(row);
+    case Locality:
+        return m_localities.at(row);
+    case Nationality:
+        return m_nationalities.at(row);
+    case BirthYear:
+        return m_birthYears.at(row);
+    case Team:
+        return m_teams.at(row);
+    default:
+        return 0;
+    }
+}
+
+QString SkiResultStore::fieldName(Field field)
+{
+    static const char *const names[FieldCount] = {
+        "year", "distance", "time", "placement", "placementMale",
+        "placementFemale", "sex", "name", "locality", "nationality",
+        "birthYear", "team"
+    };
+
+    if(field < 0 || field >= FieldCount)
+        return QString();
+
+    return QString::fromLatin1(names[field]);
+}
+
+qint32 SkiResultStore::parseTime(const QByteArray &text, quint8 *format)
+{
+    // Time is given as h:mm:ss.cc where hours and hundredths are optional
+    qint32 parts[3] = {0, 0, 0};
+    int partCount = 0;
+    qint32 value = 0;
+    int digits = 0;
+    int leadingDigits = 0;
+    qint32 fraction = 0;
+    int fractionDigits = 0;
+    bool inFraction = false;
+    bool comma = false;
+
+    for(const char c : text){
+        if(c >= '0' && c <= '9'){
+            if(inFraction){
+                if(fractionDigits < 2){
+                    fraction = fraction * 10 + (c - '0');
+                    ++fractionDigits;
+                }
+            }
+            else{
+                value = value * 10 + (c - '0');
+                ++digits;
+            }
+        }
+        else if(c == ':' && !inFraction){
+            if(digits == 0 || partCount == 2)
+                return NoTime;
+            if(partCount == 0)
+                leadingDigits = digits;
+            parts[partCount++] = value;
+            value = 0;
+            digits = 0;
+        }
+        else if((c == '.' || c == ',') && !inFraction){
+            inFraction = true;
+            comma = c == ',';
+        }
+        else if(c != ' '){
+            return NoTime;
+        }
+    }
+
+    if(digits == 0)
+        return NoTime;
+    parts[partCount++] = value;
+
+    // Minutes and seconds are required
+    if(partCount < 2)
+        return NoTime;
+
+    // The format is kept so that the time is shown as it was written
+    if(format){
+        *format = static_cast<quint8>(fractionDigits);
+        if(partCount == 3)
+            *format |= TimeHours;
+        if(leadingDigits >= 2)
+            *format |= TimePadded;
+        if(comma)
+            *format |= TimeComma;
+    }
+
+    if(fractionDigits == 1)
+        fraction *= 10;
+
+    const qint32 hours = partCount == 3 ? parts[0] : 0;
+    const qint32 minutes = parts[partCount - 2];
+    const qint32 seconds = parts[partCount - 1];
+
+    return ((hours * 60 + minutes) * 60 + seconds) * 100 + fraction;
+}
+
+QString SkiResultStore::formatTime(qint32 centiseconds, quint8 format)
+{
+    if(centiseconds < 0)
+        return QString();
+
+    const qint32 hundredths = centiseconds % 100;
+    const qint32 seconds = centiseconds / 100 % 60;
+    const qint32 minutes = centiseconds / 6000;
+    const int leadingWidth = format & TimePadded ? 2 : 1;
+
+    QString time;
+    if(format & TimeHours){
+        time = QString("%1:%2:%3").arg(minutes / 60, leadingWidth, 10, QChar('0'))
+                                  .arg(minutes % 60, 2, 10, QChar('0'))
+                                  .arg(seconds, 2, 10, QChar('0'));
+    }
+    else{
+        time = QString("%1:%2").arg(minutes, leadingWidth, 10, QChar('0'))
+                               .arg(seconds, 2, 10, QChar('0'));
+    }
+
+    const int fractionDigits = format & TimeFractionDigits;
+    const QChar separator = format & TimeComma ? QChar(',') : QChar('.');
+    if(fractionDigits == 2)
+        time += separator + QString("%1").arg(hundredths, 2, 10, QChar('0'));
+    else if(fractionDigits == 1)
+        time += separator + QString::number(hundredths / 10);
+
+    return time;
+}
+
+qint32 SkiResultStore::parseNumber(const QByteArray &text)
+{
+    qint32 number = 0;
+    for(const char c : text){
+        if(c < '0' || c > '9')
+            break;
+        number = number * 10 + (c - '0');
+    }
+    return number;
+}
+
+qint32 SkiResultStore::parsePlacement(const QByteArray &text)
+{
+    // Placements censored in anonymous mode are kept apart from results
+    // without a placement
+    if(text == RedactedText)
+        return RedactedPlacement;
+
+    return parseNumber(text);
+}
+
+void SkiResultStore::yearRange(int year, int &first, int &last) const
+{
+    // Races are ordered by year so the first race of the year is found with
+    // a binary search
+    first = std::lower_bound(m_races.constBegin(), m_races.constEnd(), year,
+                             [](const Race &race, int value){
+                                 return race.year < value;
+                             }) - m_races.constBegin();
+    last = first;
+    while(last < m_races.size() && m_races[last].year == year)
+        ++last;
+}
@@ -0,0 +1,391 @@
+#ifndef SKIRESULTSTORE_H
+#define SKIRESULTSTORE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QSharedPointer>
+
+#include "skicolumn.h"
+#include "skistringdictionary.h"
+
+class SkiResultView;
+
+/**
+ * @brief The SkiResultStore class holds every skiing result in memory in a
+ *        columnar form. Each field of a result has its own contiguous array
+ *        and text fields are stored as ids to per-field string dictionaries.
+ *        Results are ordered by year and inside a year by distance, so a
+ *        year or a single race is always a continuous range of rows that can
+ *        be scanned through SkiResultView without any allocations. The
+ *        columns and dictionaries may be borrowed from a memory-mapped
+ *        database file, in which case they are copied only when the store is
+ *        modified.
+ */
+class SkiResultStore
+{
+public:
+    /**
+     * @brief The Field enum lists the fields of a result in the same order
+     *        as they appear on the result page.
+     */
+    enum Field {
+        Year = 0,
+        Distance,
+        Time,
+        Placement,
+        PlacementMale,
+        PlacementFemale,
+        Sex,
+        Name,
+        Locality,
+        Nationality,
+        BirthYear,
+        Team,
+        FieldCount
+    };
+
+    /**
+     * @brief NoTime: Value of the time column when the result has no time
+     */
+    static const qint32 NoTime = -1;
+
+    /**
+     * @brief The TimeFormat enum tells how a time was written on the result
+     *        page, so that it is shown the same way. The lowest bits hold the
+     *        number of fraction digits and the flags are added to them.
+     */
+    enum TimeFormat {
+        TimeFractionDigits = 0x03,
+        TimeHours          = 0x04,
+        TimePadded         = 0x08,
+        TimeComma          = 0x10
+    };
+
+    /**
+     * @brief DefaultTimeFormat: Format of times in h:mm:ss.cc form
+     */
+    static const quint8 DefaultTimeFormat = TimeHours | 2;
+
+    /**
+     * @brief RedactedPlacement: Value of the placement columns when the
+     *        placement has been censored in anonymous mode
+     */
+    static const qint32 RedactedPlacement = -1;
+
+    /**
+     * @brief RedactedText: Text of the censored fields in anonymous mode
+     */
+    static const char RedactedText[];
+
+    /**
+     * @brief The RawRecord struct holds one result as UTF-8 text cells before
+     *        it is added to the store.
+     */
+    struct RawRecord {
+        QByteArray cells[FieldCount];
+    };
+
+    /**
+     * @brief The YearInfo struct tells when a year was last fetched and the
+     *        hash of its content at that time.
+     */
+    struct YearInfo {
+        qint32  year;
+        quint32 recordCount;
+        quint64 contentHash;
+        qint64  fetchedAt;
+    };
+
+    SkiResultStore();
+
+    /**
+     * @brief clear: Removes all results from the store
+     * @post Store is empty
+     */
+    void clear();
+
+    /**
+     * @brief setYear: Replaces all results of a year with the given results
+     * @param year: Year of the results
+     * @param records: Results of the year in the order of the result page
+     * @post Old results of the year are removed and new ones are added.
+     *       Columns are copied once around the year and dictionaries only
+     *       if new strings are added.
+     * @return False if the year has more distinct distances or sexes than
+     *         their columns can hold, the results are then left unchanged
+     */
+    bool setYear(int year, const QVector<RawRecord> &records);
+
+    /**
+     * @brief detach: Copies every column and dictionary borrowed from a
+     *        mapped database file to memory owned by the store
+     * @post Store doesn't keep the database file mapped
+     */
+    void detach();
+
+    /**
+     * @brief isMapped: Tells if the store reads a memory-mapped database file
+     * @return True if any column or dictionary is borrowed from a mapped
+     *         file
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief removeYear: Removes all results of a year
+     * @param year: Year to be removed
+     */
+    void removeYear(int year);
+
+    /**
+     * @brief yearInfo: Returns the fetch information of a year
+     * @param year: Year of the information
+     * @param info: Object to which the information is copied
+     * @return False if the year has never been fetched
+     */
+    bool yearInfo(int year, YearInfo &info) const;
+
+    /**
+     * @brief setYearInfo: Saves the fetch information of a year
+     * @param info: Information to save, replaces the earlier one of the year
+     */
+    void setYearInfo(const YearInfo &info);
+
+    /**
+     * @brief contentHash: Calculates a hash of the results of a year. Hash
+     *        tells if the results on the result page have changed since the
+     *        last time the year was fetched.
+     * @param records: Results of the year in the order of the result page
+     * @return Hash of the results
+     */
+    static quint64 contentHash(const QVector<RawRecord> &records);
+
+    /**
+     * @brief containsYear: Checks if the store has results from a year
+     * @param year: Year to check
+     * @return True if results are found
+     */
+    bool containsYear(int year) const;
+
+    /**
+     * @brief years: Returns all years found in the store in ascending order
+     * @return Years in the store
+     */
+    QVector<int> years() const;
+
+    /**
+     * @brief size: Returns the number of results in the store
+     * @return Number of results
+     */
+    int size() const;
+
+    /**
+     * @brief isAnonymous: Tells if the stored results have been anonymized
+     * @return True if results are anonymized
+     */
+    bool isAnonymous() const;
+
+    /**
+     * @brief setAnonymous: Marks the stored results anonymized or not
+     * @param anonymous: True if results are anonymized
+     */
+    void setAnonymous(bool anonymous);
+
+    /**
+     * @brief all: Returns a view over every result in the store
+     * @return View over all results
+     */
+    SkiResultView all() const;
+
+    /**
+     * @brief year: Returns a view over all results of a year
+     * @param year: Year of the results
+     * @return View over the results, empty if the year is not found
+     */
+    SkiResultView year(int year) const;
+
+    /**
+     * @brief race: Returns a view over the results of a single race
+     * @param year: Year of the race
+     * @param distance: Distance code of the race, for example "P50"
+     * @return View over the results, empty if the race is not found
+     */
+    SkiResultView race(int year, const QString &distance) const;
+
+    /**
+     * @brief races: Returns views over every race of a year
+     * @param year: Year of the races
+     * @return One view for each race of the year
+     */
+    QVector<SkiResultView> races(int year) const;
+
+    /**
+     * @brief dictionary: Returns the string dictionary of a text field
+     * @param field: One of Distance, Sex, Name, Locality, Nationality,
+     *        BirthYear or Team
+     * @return Dictionary of the field
+     */
+    const SkiStringDictionary &dictionary(Field field) const;
+
+    /**
+     * @brief text: Returns the value of any field of a row as text
+     * @param field: Field to return
+     * @param row: Row in the store
+     * @return Value of the field as it is shown to the user
+     */
+    QString text(Field field, int row) const;
+
+    /**
+     * @brief idAt: Returns the dictionary id of a text field of a row
+     * @param field: Text field to return
+     * @param row: Row in the store
+     * @return Id of the value in dictionary(field)
+     */
+    quint32 idAt(Field field, int row) const;
+
+    int yearAt(int row) const { return m_years.at(row); }
+    quint32 distanceAt(int row) const { return m_distances.at(row); }
+    qint32 timeAt(int row) const { return m_times.at(row); }
+    quint8 timeFormatAt(int row) const { return m_timeFormats.at(row); }
+    qint32 placementAt(int row) const { return m_placements.at(row); }
+    qint32 placementMaleAt(int row) const { return m_placementsMale.at(row); }
+    qint32 placementFemaleAt(int row) const { return m_placementsFemale.at(row); }
+    quint32 sexAt(int row) const { return m_sexes.at(row); }
+    quint32 nameAt(int row) const { return m_names.at(row); }
+    quint32 localityAt(int row) const { return m_localities.at(row); }
+    quint32 nationalityAt(int row) const { return m_nationalities.at(row); }
+    quint32 birthYearAt(int row) const { return m_birthYears.at(row); }
+    quint32 teamAt(int row) const { return m_teams.at(row); }
+
+    /**
+     * @brief fieldName: Returns the name of a field used in the data files
+     * @param field: Field
+     * @return Name of the field, for example "placementMale"
+     */
+    static QString fieldName(Field field);
+
+    /**
+     * @brief parseTime: Converts time in h:mm:ss.cc form to centiseconds
+     * @param text: Time as text, hours and hundredths are optional
+     * @param format: If given, receives the TimeFormat of the text
+     * @return Time in centiseconds or NoTime if the text is not a time
+     */
+    static qint32 parseTime(const QByteArray &text, quint8 *format = nullptr);
+
+    /**
+     * @brief formatTime: Converts centiseconds to text
+     * @param centiseconds: Time in centiseconds
+     * @param format: TimeFormat given by parseTime
+     * @return Time as text, empty if the time is NoTime
+     */
+    static QString formatTime(qint32 centiseconds,
+                              quint8 format = DefaultTimeFormat);
+
+    /**
+     * @brief parseNumber: Converts the leading digits of a text to a number
+     * @param text: Number as text, for example placement "12."
+     * @return Number or 0 if the text doesn't start with a digit
+     */
+    static qint32 parseNumber(const QByteArray &text);
+
+    /**
+     * @brief parsePlacement: Converts a placement to a number
+     * @param text: Placement as text, for example "12." or RedactedText
+     * @return Number, RedactedPlacement or 0 if the result has no placement
+     */
+    static qint32 parsePlacement(const QByteArray &text);
+
+private:
+    friend class SkiSnapshot;
+
+    /**
+     * @brief The Race struct tells the range of rows of a single race.
+     */
+    struct Race {
+        qint16  year;
+        quint16 distance;
+        qint32  begin;
+        qint32  end;
+    };
+
+    /**
+     * @brief yearRange: Finds the races of a year
+     * @param year: Year of the races
+     * @param first: Index of the first race of the year in m_races
+     * @param last: Index one past the last race of the year in m_races
+     */
+    void yearRange(int year, int &first, int &last) const;
+
+    QVector<Race>          m_races;
+    QVector<YearInfo>      m_yearInfos;
+    SkiStringDictionary    m_dictionaries[FieldCount];
+    bool                   m_anonymous;
+    QSharedPointer<QFile>  m_mappedFile;
+    QByteArray             m_fileBuffer;
+
+    SkiColumn<qint16>      m_years;
+    SkiColumn<quint16>     m_distances;
+    SkiColumn<qint32>      m_times;
+    SkiColumn<quint8>      m_timeFormats;
+    SkiColumn<qint32>      m_placements;
+    SkiColumn<qint32>      m_placementsMale;
+    SkiColumn<qint32>      m_placementsFemale;
+    SkiColumn<quint8>      m_sexes;
+    SkiColumn<quint32>     m_names;
+    SkiColumn<quint32>     m_localities;
+    SkiColumn<quint32>     m_nationalities;
+    SkiColumn<quint32>     m_birthYears;
+    SkiColumn<quint32>     m_teams;
+};
+
+/**
+ * @brief The SkiResultView class is a read-only window to a continuous range
+ *        of rows in SkiResultStore. It is cheap to copy and reads the columns
+ *        of the store directly. Indexes given to the accessors are relative
+ *        to the beginning of the view.
+ */
+class SkiResultView
+{
+public:
+    SkiResultView() : m_store(nullptr), m_begin(0), m_end(0) {}
+    SkiResultView(const SkiResultStore *store, int begin, int end) :
+        m_store(store), m_begin(begin), m_end(end) {}
+
+    int size() const { return m_end - m_begin; }
+    bool isEmpty() const { return m_end == m_begin; }
+
+    /**
+     * @brief row: Converts an index of the view to a row of the store
+     * @param i: Index in the view
+     * @return Row in the store
+     */
+    int row(int i) const { return m_begin + i; }
+
+    const SkiResultStore *store() const { return m_store; }
+
+    int year(int i) const { return m_store->yearAt(m_begin + i); }
+    quint32 distance(int i) const { return m_store->distanceAt(m_begin + i); }
+    qint32 time(int i) const { return m_store->timeAt(m_begin + i); }
+    qint32 placement(int i) const { return m_store->placementAt(m_begin + i); }
+    qint32 placementMale(int i) const { return m_store->placementMaleAt(m_begin + i); }
+    qint32 placementFemale(int i) const { return m_store->placementFemaleAt(m_begin + i); }
+    quint32 sex(int i) const { return m_store->sexAt(m_begin + i); }
+    quint32 name(int i) const { return m_store->nameAt(m_begin + i); }
+    quint32 locality(int i) const { return m_store->localityAt(m_begin + i); }
+    quint32 nationality(int i) const { return m_store->nationalityAt(m_begin + i); }
+    quint32 birthYear(int i) const { return m_store->birthYearAt(m_begin + i); }
+    quint32 team(int i) const { return m_store->teamAt(m_begin + i); }
+
+    QString text(SkiResultStore::Field field, int i) const
+    {
+        return m_store->text(field, m_begin + i);
+    }
+
+private:
+    const SkiResultStore *m_store;
+    int                   m_begin;
+    int                   m_end;
+};
+
+#endif // SKIRESULTSTORE_H
@@ -0,0 +1,81 @@
+#include "skisearchfilter.h"
+
+#include <algorithm>
+
+SkiSearchFilter::SkiSearchFilter(const SkiResultStore &store) :
+    m_store(store),
+    m_matchesNothing(false)
+{}
+
+void SkiSearchFilter::requireValue(SkiResultStore::Field field,
+                                   const QString &value)
+{
+    const qint64 id = m_store.dictionary(field).find(value.toUtf8());
+    if(id == -1){
+        m_matchesNothing = true;
+        return;
+    }
+
+    // A single value rejects about as many rows as there are other values
+    Condition condition;
+    condition.kind = Value;
+    condition.field = field;
+    condition.id = static_cast<quint32>(id);
+    condition.minTime = 0;
+    condition.maxTime = 0;
+    condition.selectivity = 1.0 / qMax(1, m_store.dictionary(field).size() - 1);
+    m_conditions.append(condition);
+}
+
+void SkiSearchFilter::requireTime(qint32 minTime, qint32 maxTime)
+{
+    if(minTime > maxTime){
+        m_matchesNothing = true;
+        return;
+    }
+
+    // Time limits are given in whole hours and usually accept most rows
+    Condition condition;
+    condition.kind = TimeRange;
+    condition.field = SkiResultStore::Time;
+    condition.id = 0;
+    condition.minTime = minTime;
+    condition.maxTime = maxTime;
+    condition.selectivity = 0.75;
+    m_conditions.append(condition);
+}
+
+void SkiSearchFilter::compile()
+{
+    // Rows rejected by the first condition are never tested further
+    std::stable_sort(m_conditions.begin(), m_conditions.end(),
+                     [](const Condition &a, const Condition &b){
+        return a.selectivity < b.selectivity;
+    });
+}
+
+bool SkiSearchFilter::matchesNothing() const
+{
+    return m_matchesNothing;
+}
+
+bool SkiSearchFilter::matches(int row) const
+{
+    for(const Condition &condition : m_conditions){
+        switch(condition.kind){
+        case Value:
+            if(m_store.idAt(condition.field, row) != condition.id)
+                return false;
+            break;
+
+        case TimeRange:{
+            const qint32 time = m_store.timeAt(row);
+            if(time == SkiResultStore::NoTime || time < condition.minTime
+                    || time > condition.maxTime)
+                return false;
+            break;
+        }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef SKISEARCHFILTER_H
+#define SKISEARCHFILTER_H
+
+#include <QString>
+#include <QVector>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiSearchFilter class is a set of conditions a row of the result
+ *        store must meet. Values of text fields are looked up from the
+ *        string dictionary when they are added, so testing a row only
+ *        compares ids and integers. Before scanning, compile() orders the
+ *        conditions so that the ones that reject most rows are tested first.
+ */
+class SkiSearchFilter
+{
+public:
+    /**
+     * @brief SkiSearchFilter: Creates a filter that accepts every row
+     * @param store: Store whose rows are tested
+     * @pre Store is not modified while the filter is used
+     */
+    explicit SkiSearchFilter(const SkiResultStore &store);
+
+    /**
+     * @brief requireValue: Accepts only rows whose text field is the value
+     * @param field: Text field to test
+     * @param value: Value of the field
+     */
+    void requireValue(SkiResultStore::Field field, const QString &value);
+
+    /**
+     * @brief requireTime: Accepts only rows that have a time within limits
+     * @param minTime: Smallest time in centiseconds
+     * @param maxTime: Largest time in centiseconds
+     */
+    void requireTime(qint32 minTime, qint32 maxTime);
+
+    /**
+     * @brief compile: Orders the conditions from the most selective to the
+     *        least selective
+     * @post Conditions are ready for matches()
+     */
+    void compile();
+
+    /**
+     * @brief matchesNothing: Tells if some condition can't match any row
+     * @return True if no row can match
+     */
+    bool matchesNothing() const;
+
+    /**
+     * @brief matches: Tests a row of the store
+     * @param row: Row in the store
+     * @return True if the row meets every condition
+     */
+    bool matches(int row) const;
+
+private:
+    enum Kind {
+        Value,
+        TimeRange
+    };
+
+    /**
+     * @brief The Condition struct is one compiled condition.
+     */
+    struct Condition {
+        Kind                  kind;
+        SkiResultStore::Field field;
+        quint32               id;
+        qint32                minTime;
+        qint32                maxTime;
+        double                selectivity;
+    };
+
+    const SkiResultStore &m_store;
+    QVector<Condition>    m_conditions;
+    bool                  m_matchesNothing;
+};
+
+#endif // SKISEARCHFILTER_H
@@ -0,0 +1,146 @@
+#include "skisearchtask.h"
+#include "skiyearscan.h"
+
+#include <algorithm>
+
+SkiSearchTask::SkiSearchTask(const SkiResultStore &store, int fromYear,
+                             int toYear, const QString &distance, int limit,
+                             int blockSize) :
+    m_store(store),
+    m_filter(m_store),
+    m_indexed(false),
+    m_fromYear(fromYear),
+    m_toYear(toYear),
+    m_year(fromYear),
+    m_distance(distance),
+    m_limit(limit),
+    m_blockSize(qMax(1, blockSize)),
+    m_pool(nullptr)
+{
+    // Races are found through the lookup of the distance dictionary, which
+    // is built on first use. It is built here before any parallel scan.
+    if(m_distance != "all")
+        m_store.dictionary(SkiResultStore::Distance).find(m_distance.toUtf8());
+}
+
+SkiSearchFilter &SkiSearchTask::filter()
+{
+    return m_filter;
+}
+
+void SkiSearchTask::setCandidates(const QVector<int> &rows)
+{
+    m_candidates = rows;
+    m_indexed = true;
+}
+
+void SkiSearchTask::setThreadPool(QThreadPool *pool)
+{
+    m_pool = pool;
+}
+
+QVector<SkiResultSetPtr> SkiSearchTask::step()
+{
+    QVector<SkiResultSetPtr> blocks;
+    if(isFinished())
+        return blocks;
+
+    // Nothing is searched if some condition can't match
+    if(m_filter.matchesNothing() || (m_indexed && m_candidates.isEmpty())){
+        m_year = m_toYear + 1;
+        return blocks;
+    }
+
+    // With a thread pool a step searches as many years as there are threads
+    const int years = m_pool ? qMax(1, m_pool->maxThreadCount()) : 1;
+    const int first = m_year;
+    const int last = qMin(m_toYear, first + years - 1);
+    m_year = last + 1;
+
+    const QVector<QVector<SkiResultSetPtr>> found = SkiYearScan::map(
+                m_pool, first, last, [this](int year){
+        return scanYear(year);
+    });
+    for(const QVector<SkiResultSetPtr> &yearBlocks : found)
+        blocks += yearBlocks;
+
+    m_results += blocks;
+    return blocks;
+}
+
+QVector<SkiResultSetPtr> SkiSearchTask::scanYear(int year) const
+{
+    QVector<SkiResultSetPtr> blocks;
+
+    SkiResultView data;
+    if(m_distance != "all")
+        data = m_store.race(year, m_distance);
+    else
+        data = m_store.year(year);
+    if(data.isEmpty())
+        return blocks;
+
+    QVector<int> rows;
+    int found = 0;
+    auto take = [&](int row){
+        if(!m_filter.matches(row))
+            return;
+        rows << row;
+        found++;
+        if(rows.size() == m_blockSize){
+            blocks << SkiResultSetPtr(new SkiResultSet(m_store, rows));
+            rows.clear();
+        }
+    };
+
+    // The scan of the year stops when the limit is reached. With index
+    // lookups only the candidates inside the rows of the year are tested.
+    if(m_indexed){
+        const int end = data.row(data.size());
+        auto it = std::lower_bound(m_candidates.constBegin(),
+                                   m_candidates.constEnd(), data.row(0));
+        for(; it != m_candidates.constEnd() && *it < end && found < m_limit; ++it)
+            take(*it);
+    }
+    else{
+        for(int i = 0; i < data.size() && found < m_limit; ++i)
+            take(data.row(i));
+    }
+
+    // Rest of the year is sent as a smaller block so that partial results
+    // are shown as soon as a year is searched
+    if(!rows.isEmpty())
+        blocks << SkiResultSetPtr(new SkiResultSet(m_store, rows));
+
+    return blocks;
+}
+
+bool SkiSearchTask::isFinished() const
+{
+    return m_year > m_toYear;
+}
+
+int SkiSearchTask::progress() const
+{
+    return qMax(0, qMin(m_year, m_toYear + 1) - m_fromYear);
+}
+
+int SkiSearchTask::total() const
+{
+    return qMax(0, m_toYear - m_fromYear + 1);
+}
+
+int SkiSearchTask::fromYear() const
+{
+    return m_fromYear;
+}
+
+int SkiSearchTask::toYear() const
+{
+    return m_toYear;
+}
+
+const QVector<SkiResultSetPtr> &SkiSearchTask::results() const
+{
+    return m_results;
+}
@@ -0,0 +1,117 @@
+#ifndef SKISEARCHTASK_H
+#define SKISEARCHTASK_H
+
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include "skiresultstore.h"
+#include "skisearchfilter.h"
+#include "skiresultset.h"
+
+/**
+ * @brief The SkiSearchTask class is a search that is run one year at a time,
+ *        so that the analyzer can send partial results and handle other
+ *        requests between the years. The task keeps its own copy of the
+ *        store, which shares the columns with the original, so the rows it
+ *        has found stay valid if the retriever replaces the store while the
+ *        search is running.
+ */
+class SkiSearchTask
+{
+public:
+    /**
+     * @brief SkiSearchTask: Creates a search that accepts every row
+     * @param store: Store to search
+     * @param fromYear: First year to search
+     * @param toYear: Last year to search
+     * @param distance: Distance code of the searched race or "all"
+     * @param limit: Number of results taken from each year at most
+     * @param blockSize: Number of rows in a result set at most
+     */
+    SkiSearchTask(const SkiResultStore &store, int fromYear, int toYear,
+                  const QString &distance, int limit, int blockSize);
+
+    /**
+     * @brief filter: Returns the filter the rows are tested with
+     * @return Filter over the store of the task
+     * @pre Filter is compiled before the first step
+     */
+    SkiSearchFilter &filter();
+
+    /**
+     * @brief setCandidates: Tests only the given rows
+     * @param rows: Rows of the store in ascending order
+     */
+    void setCandidates(const QVector<int> &rows);
+
+    /**
+     * @brief setThreadPool: Searches several years at a time on a pool
+     * @param pool: Thread pool, or nullptr to search one year at a time in
+     *        the calling thread
+     */
+    void setThreadPool(QThreadPool *pool);
+
+    /**
+     * @brief step: Searches the next year, or the next years in parallel if
+     *        the task has a thread pool
+     * @return Results found from the years in year order, in blocks of at
+     *         most blockSize rows
+     * @pre Task isn't finished
+     */
+    QVector<SkiResultSetPtr> step();
+
+    /**
+     * @brief isFinished: Tells if every year has been searched
+     * @return True if the search is complete
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief progress: Returns the number of searched years
+     * @return Searched years
+     */
+    int progress() const;
+
+    /**
+     * @brief total: Returns the number of years to search
+     * @return Years to search
+     */
+    int total() const;
+
+    int fromYear() const;
+    int toYear() const;
+
+    /**
+     * @brief results: Returns every result found so far
+     * @return Results returned by the steps
+     */
+    const QVector<SkiResultSetPtr> &results() const;
+
+private:
+    // The filter refers to the store of the task
+    Q_DISABLE_COPY(SkiSearchTask)
+
+    /**
+     * @brief scanYear: Searches one year. Only reads the task, so years can
+     *        be searched in parallel.
+     * @param year: Year to search
+     * @return Results found from the year
+     */
+    QVector<SkiResultSetPtr> scanYear(int year) const;
+
+    SkiResultStore           m_store;
+    SkiSearchFilter          m_filter;
+    QVector<int>             m_candidates;
+    bool                     m_indexed;
+    int                      m_fromYear;
+    int                      m_toYear;
+    int                      m_year;
+    QString                  m_distance;
+    int                      m_limit;
+    int                      m_blockSize;
+    QThreadPool*             m_pool;
+    QVector<SkiResultSetPtr> m_results;
+};
+
+#endif // SKISEARCHTASK_H
@@ -0,0 +1,349 @@
+#include "skisnapshot.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char    Magic[4]      = {'S', 'K', 'I', 'S'};
+const quint32 Version       = 4;
+const quint32 ByteOrderMark = 0x01020304;
+const quint32 AnonymousFlag = 0x1;
+
+/**
+ * @brief The Header struct is the fixed size beginning of a snapshot file.
+ *        Index checksum covers the race and year tables following the header
+ *        and content checksum covers every byte after them.
+ */
+struct Header {
+    char    magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 flags;
+    quint32 recordCount;
+    quint32 raceCount;
+    quint32 yearCount;
+    quint32 reserved;
+    quint64 indexChecksum;
+    quint64 contentChecksum;
+};
+
+static_assert(sizeof(Header) == 48, "Snapshot header must be 48 bytes");
+static_assert(sizeof(SkiResultStore::YearInfo) == 24,
+              "Year information must be 24 bytes");
+
+// Text fields in the order their dictionaries are saved
+const SkiResultStore::Field TextFields[] = {
+    SkiResultStore::Distance, SkiResultStore::Sex, SkiResultStore::Name,
+    SkiResultStore::Locality, SkiResultStore::Nationality,
+    SkiResultStore::BirthYear, SkiResultStore::Team
+};
+
+/**
+ * @brief checksum: Calculates 64-bit FNV-1a hash of the data
+ * @param data: Data to hash
+ * @param size: Size of the data in bytes
+ * @return Hash of the data
+ */
+quint64 checksum(const char *data, qint64 size)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for(qint64 i = 0; i < size; ++i){
+        hash ^= static_cast<quint8>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief align: Pads the buffer with zeros to the next 8 byte boundary
+ * @param out: Buffer to pad
+ */
+void align(QByteArray &out)
+{
+    while(out.size() % 8 != 0)
+        out.append('\0');
+}
+
+template <typename T>
+void appendValue(QByteArray &out, const T &value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void appendColumn(QByteArray &out, const SkiColumn<T> &column)
+{
+    out.append(reinterpret_cast<const char *>(column.constData()),
+               column.size() * static_cast<int>(sizeof(T)));
+    align(out);
+}
+
+/**
+ * @brief idsInRange: Checks that every id of a text column is found in the
+ *        dictionary of the field
+ * @param column: Ids of the column
+ * @param dictionary: Dictionary of the field
+ * @return False if some id is out of the dictionary
+ */
+template <typename T>
+bool idsInRange(const SkiColumn<T> &column, const SkiStringDictionary &dictionary)
+{
+    const quint32 size = static_cast<quint32>(dictionary.size());
+    for(const T *id = column.constBegin(); id != column.constEnd(); ++id){
+        if(static_cast<quint32>(*id) >= size)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The Reader class walks through the sections of a snapshot and
+ *        checks that nothing is read past its end. Columns are not copied,
+ *        they point directly to the snapshot.
+ */
+class Reader
+{
+public:
+    Reader(const char *data, qint64 size) :
+        m_data(data), m_size(size), m_pos(0) {}
+
+    qint64 pos() const { return m_pos; }
+
+    const char *take(qint64 bytes)
+    {
+        if(bytes < 0 || m_pos + bytes > m_size)
+            return nullptr;
+        const char *data = m_data + m_pos;
+        m_pos += bytes;
+        return data;
+    }
+
+    template <typename T>
+    bool value(T &value)
+    {
+        const char *data = take(sizeof(T));
+        if(!data)
+            return false;
+        std::memcpy(&value, data, sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    bool column(SkiColumn<T> &column, int count)
+    {
+        const char *data = take(static_cast<qint64>(count) * sizeof(T));
+        if(!data)
+            return false;
+        column.map(reinterpret_cast<const T *>(data), count);
+        return align();
+    }
+
+    bool align()
+    {
+        return take((8 - m_pos % 8) % 8) != nullptr;
+    }
+
+private:
+    const char *m_data;
+    qint64      m_size;
+    qint64      m_pos;
+};
+
+}
+
+bool SkiSnapshot::write(const QString &filename, const SkiResultStore &store)
+{
+    QByteArray out;
+    out.reserve(static_cast<int>(sizeof(Header)) + store.size() * 48);
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrder = ByteOrderMark;
+    header.flags = store.isAnonymous() ? AnonymousFlag : 0;
+    header.recordCount = static_cast<quint32>(store.size());
+    header.raceCount = static_cast<quint32>(store.m_races.size());
+    header.yearCount = static_cast<quint32>(store.m_yearInfos.size());
+    header.reserved = 0;
+    header.indexChecksum = 0;
+    header.contentChecksum = 0;
+    appendValue(out, header);
+
+    // Race table works as the index of years and distances
+    for(const SkiResultStore::Race &race : store.m_races){
+        appendValue(out, race.year);
+        appendValue(out, race.distance);
+        appendValue(out, race.begin);
+        appendValue(out, race.end);
+    }
+    align(out);
+
+    // Fetch information of the years
+    for(const SkiResultStore::YearInfo &info : store.m_yearInfos)
+        appendValue(out, info);
+    align(out);
+    const int contentBegin = out.size();
+
+    // String dictionaries
+    for(SkiResultStore::Field field : TextFields){
+        const SkiStringDictionary &dictionary = store.m_dictionaries[field];
+        appendValue(out, static_cast<quint32>(dictionary.offsets().size()));
+        appendValue(out, static_cast<quint32>(dictionary.blob().size()));
+        appendColumn(out, dictionary.offsets());
+        appendColumn(out, dictionary.blob());
+    }
+
+    // Record columns
+    appendColumn(out, store.m_years);
+    appendColumn(out, store.m_distances);
+    appendColumn(out, store.m_times);
+    appendColumn(out, store.m_timeFormats);
+    appendColumn(out, store.m_placements);
+    appendColumn(out, store.m_placementsMale);
+    appendColumn(out, store.m_placementsFemale);
+    appendColumn(out, store.m_sexes);
+    appendColumn(out, store.m_names);
+    appendColumn(out, store.m_localities);
+    appendColumn(out, store.m_nationalities);
+    appendColumn(out, store.m_birthYears);
+    appendColumn(out, store.m_teams);
+
+    header.indexChecksum = checksum(out.constData() + sizeof(Header),
+                                    contentBegin - static_cast<int>(sizeof(Header)));
+    header.contentChecksum = checksum(out.constData() + contentBegin,
+                                      out.size() - contentBegin);
+    std::memcpy(out.data(), &header, sizeof(Header));
+
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)){
+        return false;
+    }
+
+    if(file.write(out) != out.size()){
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool SkiSnapshot::read(const QString &filename, SkiResultStore &store,
+                       bool verifyContent)
+{
+    store.clear();
+
+    QSharedPointer<QFile> file(new QFile(filename));
+    if(!file->open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    // Map the whole file. If the file system doesn't support mapping, the
+    // file is read to a buffer which the store then keeps instead.
+    const qint64 size = file->size();
+    const char *data = reinterpret_cast<const char *>(file->map(0, size));
+    if(data){
+        store.m_mappedFile = file;
+    }
+    else{
+        store.m_fileBuffer = file->readAll();
+        data = store.m_fileBuffer.constData();
+    }
+
+    Reader reader(data, size);
+
+    Header header;
+    if(!reader.value(header)
+            || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+            || header.version != Version
+            || header.byteOrder != ByteOrderMark){
+        store.clear();
+        return false;
+    }
+
+    const int records = static_cast<int>(header.recordCount);
+    bool ok = true;
+
+    // Races must be in year order and their row ranges must not overlap,
+    // because views of a year span from its first race to its last one
+    store.m_races.resize(static_cast<int>(header.raceCount));
+    qint16 previousYear = std::numeric_limits<qint16>::min();
+    qint32 previousEnd = 0;
+    for(SkiResultStore::Race &race : store.m_races){
+        ok = ok && reader.value(race.year) && reader.value(race.distance)
+                && reader.value(race.begin) && reader.value(race.end)
+                && race.begin >= previousEnd && race.begin <= race.end
+                && race.end <= records && race.year >= previousYear;
+        previousYear = race.year;
+        previousEnd = race.end;
+    }
+    ok = ok && reader.align();
+
+    store.m_yearInfos.resize(static_cast<int>(header.yearCount));
+    for(SkiResultStore::YearInfo &info : store.m_yearInfos)
+        ok = ok && reader.value(info);
+    ok = ok && reader.align();
+
+    const qint64 contentBegin = reader.pos();
+    ok = ok && checksum(data + sizeof(Header), contentBegin - sizeof(Header))
+                == header.indexChecksum;
+    ok = ok && (!verifyContent
+                || checksum(data + contentBegin, size - contentBegin)
+                   == header.contentChecksum);
+
+    for(SkiResultStore::Field field : TextFields){
+        quint32 offsetCount = 0;
+        quint32 blobSize = 0;
+        ok = ok && reader.value(offsetCount) && reader.value(blobSize);
+
+        const char *offsets = ok ? reader.take(offsetCount * sizeof(quint32))
+                                 : nullptr;
+        ok = ok && offsets && reader.align();
+
+        const char *blob = ok ? reader.take(blobSize) : nullptr;
+        ok = ok && blob && reader.align()
+                && store.m_dictionaries[field].map(
+                    blob, static_cast<int>(blobSize),
+                    reinterpret_cast<const quint32 *>(offsets),
+                    static_cast<int>(offsetCount));
+    }
+
+    ok = ok && reader.column(store.m_years, records)
+            && reader.column(store.m_distances, records)
+            && reader.column(store.m_times, records)
+            && reader.column(store.m_timeFormats, records)
+            && reader.column(store.m_placements, records)
+            && reader.column(store.m_placementsMale, records)
+            && reader.column(store.m_placementsFemale, records)
+            && reader.column(store.m_sexes, records)
+            && reader.column(store.m_names, records)
+            && reader.column(store.m_localities, records)
+            && reader.column(store.m_nationalities, records)
+            && reader.column(store.m_birthYears, records)
+            && reader.column(store.m_teams, records);
+
+    // Ids index the dictionaries and the tables built from them without
+    // checks, so every id is checked even if the content checksum isn't.
+    // Only the id columns are read, the times and placements stay on disk.
+    ok = ok && idsInRange(store.m_distances, store.m_dictionaries[SkiResultStore::Distance])
+            && idsInRange(store.m_sexes, store.m_dictionaries[SkiResultStore::Sex])
+            && idsInRange(store.m_names, store.m_dictionaries[SkiResultStore::Name])
+            && idsInRange(store.m_localities, store.m_dictionaries[SkiResultStore::Locality])
+            && idsInRange(store.m_nationalities, store.m_dictionaries[SkiResultStore::Nationality])
+            && idsInRange(store.m_birthYears, store.m_dictionaries[SkiResultStore::BirthYear])
+            && idsInRange(store.m_teams, store.m_dictionaries[SkiResultStore::Team]);
+    for(const SkiResultStore::Race &race : store.m_races){
+        ok = ok && race.distance < store.m_dictionaries[SkiResultStore::Distance].size();
+    }
+
+    if(!ok){
+        store.clear();
+        return false;
+    }
+
+    store.setAnonymous(header.flags & AnonymousFlag);
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef SKISNAPSHOT_H
+#define SKISNAPSHOT_H
+
+#include <QString>
+
+#include "skiresultstore.h"
+
+/**
+ * @brief The SkiSnapshot class saves SkiResultStore to a compact binary file
+ *        and loads it back. The file starts with a fixed size header that
+ *        holds a magic, format version, byte order mark, flags, record and
+ *        race counts and checksums of the index and of the content. The
+ *        header is followed by the race table (row range of every race of
+ *        every year), the year table (fetch time and content hash of every
+ *        fetched year), the string dictionaries of the text fields and one
+ *        fixed-width array per column. Every section starts at an 8 byte
+ *        boundary. The file is written in the byte order of the host and a
+ *        file with a different byte order, version or checksum is rejected.
+ *
+ *        Reading maps the file to memory and the store uses the columns and
+ *        dictionaries directly from the mapped pages. The ids of the text
+ *        columns are checked when the file is read, the other columns of a
+ *        year are read from the disk only when it is first scanned, and
+ *        processes reading the same file share one physical copy.
+ */
+class SkiSnapshot
+{
+public:
+    /**
+     * @brief write: Saves the store to a snapshot file
+     * @param filename: Filename of the snapshot
+     * @param store: Store to be saved
+     * @return Boolean indicating if saving was successful
+     * @post File is replaced atomically, old file is kept on failure
+     */
+    static bool write(const QString &filename, const SkiResultStore &store);
+
+    /**
+     * @brief read: Maps a snapshot file to the store
+     * @param filename: Filename of the snapshot
+     * @param store: Store to which the snapshot is mapped
+     * @param verifyContent: Checks also the content checksum. This reads the
+     *        whole file, so by default only the index checksum, the race
+     *        ranges, the dictionary offsets and the ids of the text columns
+     *        are checked and the other record columns aren't read.
+     * @return Boolean indicating if reading was successful
+     * @post On failure the store is left empty
+     */
+    static bool read(const QString &filename, SkiResultStore &store,
+                     bool verifyContent = false);
+};
+
+#endif // SKISNAPSHOT_H
@@ -0,0 +1,152 @@
+#include "skistringdictionary.h"
+
+SkiStringDictionary::SkiStringDictionary() :
+    m_lookupBuilt(true)
+{
+    clear();
+}
+
+quint32 SkiStringDictionary::intern(const QByteArray &utf8)
+{
+    if(utf8.isEmpty())
+        return 0;
+
+    buildLookup();
+    QHash<QByteArray, quint32>::const_iterator it = m_lookup.constFind(utf8);
+    if(it != m_lookup.constEnd())
+        return it.value();
+
+    detach();
+    buildLookup();
+
+    // Append the string to the end of the buffer. Offsets always hold one
+    // more entry than there are strings so that the length of each string
+    // is the difference of two neighbouring offsets.
+    const quint32 id = m_offsets.size() - 1;
+    m_blob.append(utf8.constData(), utf8.size());
+    m_offsets.append(m_blob.size());
+    m_lookup.insert(utf8, id);
+
+    return id;
+}
+
+qint64 SkiStringDictionary::find(const QByteArray &utf8) const
+{
+    if(utf8.isEmpty())
+        return 0;
+
+    buildLookup();
+    QHash<QByteArray, quint32>::const_iterator it = m_lookup.constFind(utf8);
+    if(it == m_lookup.constEnd())
+        return -1;
+
+    return it.value();
+}
+
+QString SkiStringDictionary::text(quint32 id) const
+{
+    if(id >= static_cast<quint32>(size()))
+        return QString();
+
+    const quint32 begin = m_offsets.at(id);
+    const quint32 end = m_offsets.at(id + 1);
+    return QString::fromUtf8(m_blob.constData() + begin, end - begin);
+}
+
+QByteArray SkiStringDictionary::utf8(quint32 id) const
+{
+    if(id >= static_cast<quint32>(size()))
+        return QByteArray();
+
+    const quint32 begin = m_offsets.at(id);
+    const quint32 end = m_offsets.at(id + 1);
+    return QByteArray(m_blob.constData() + begin, end - begin);
+}
+
+int SkiStringDictionary::size() const
+{
+    return m_offsets.size() - 1;
+}
+
+void SkiStringDictionary::clear()
+{
+    m_blob.clear();
+    m_offsets.clear();
+    m_lookup.clear();
+    m_lookupBuilt = true;
+
+    // Empty string has always id 0
+    m_offsets.append(0);
+    m_offsets.append(0);
+}
+
+const SkiColumn<char> &SkiStringDictionary::blob() const
+{
+    return m_blob;
+}
+
+const SkiColumn<quint32> &SkiStringDictionary::offsets() const
+{
+    return m_offsets;
+}
+
+bool SkiStringDictionary::map(const char *blob, int blobSize,
+                              const quint32 *offsets, int offsetCount)
+{
+    // Offsets must start from the empty string, never decrease and end at
+    // the end of the buffer. Checking them once here lets strings be read
+    // without checks.
+    if(offsetCount < 2 || blobSize < 0 || offsets[0] != 0 || offsets[1] != 0
+            || offsets[offsetCount - 1] != static_cast<quint32>(blobSize))
+        return false;
+    for(int i = 1; i < offsetCount; ++i){
+        if(offsets[i] < offsets[i - 1])
+            return false;
+    }
+
+    m_blob.map(blob, blobSize);
+    m_offsets.map(offsets, offsetCount);
+    m_lookup.clear();
+    m_lookupBuilt = false;
+
+    return true;
+}
+
+bool SkiStringDictionary::isMapped() const
+{
+    return m_blob.isMapped() || m_offsets.isMapped();
+}
+
+void SkiStringDictionary::detach()
+{
+    if(!isMapped())
+        return;
+
+    m_blob.detach();
+    m_offsets.detach();
+
+    // Keys of a mapped dictionary point to the mapped strings, so they are
+    // rebuilt from the copies when needed
+    m_lookup.clear();
+    m_lookupBuilt = false;
+}
+
+void SkiStringDictionary::buildLookup() const
+{
+    if(m_lookupBuilt)
+        return;
+
+    // Mapped strings are used as keys without copying them
+    m_lookup.reserve(size());
+    for(int id = 1; id < size(); ++id){
+        const quint32 begin = m_offsets.at(id);
+        const quint32 end = m_offsets.at(id + 1);
+        if(m_blob.isMapped())
+            m_lookup.insert(QByteArray::fromRawData(m_blob.constData() + begin,
+                                                    end - begin), id);
+        else
+            m_lookup.insert(utf8(id), id);
+    }
+
+    m_lookupBuilt = true;
+}
@@ -0,0 +1,116 @@
+#ifndef SKISTRINGDICTIONARY_H
+#define SKISTRINGDICTIONARY_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+#include "skicolumn.h"
+
+/**
+ * @brief The SkiStringDictionary class stores every distinct string of one
+ *        result field once and hands out dense 32-bit ids for them. Strings
+ *        are kept as UTF-8 in a single contiguous buffer which can also be
+ *        borrowed from a memory-mapped database file. Id 0 is always the
+ *        empty string.
+ */
+class SkiStringDictionary
+{
+public:
+    SkiStringDictionary();
+
+    /**
+     * @brief intern: Returns the id of the given string and adds it to the
+     *        dictionary if it isn't there yet
+     * @param utf8: String in UTF-8
+     * @return Id of the string
+     */
+    quint32 intern(const QByteArray &utf8);
+
+    /**
+     * @brief find: Looks up the id of the given string
+     * @param utf8: String in UTF-8
+     * @return Id of the string or -1 if the string is not in the dictionary
+     */
+    qint64 find(const QByteArray &utf8) const;
+
+    /**
+     * @brief text: Returns the string behind the id
+     * @param id: Id of the string
+     * @return String as QString, empty if the id is not in the dictionary
+     */
+    QString text(quint32 id) const;
+
+    /**
+     * @brief utf8: Returns the string behind the id as UTF-8
+     * @param id: Id of the string
+     * @return String as UTF-8, empty if the id is not in the dictionary
+     */
+    QByteArray utf8(quint32 id) const;
+
+    /**
+     * @brief size: Returns the number of strings in the dictionary
+     * @return Number of strings, including the empty string
+     */
+    int size() const;
+
+    /**
+     * @brief clear: Removes every string except the empty string
+     * @post Dictionary contains only id 0
+     */
+    void clear();
+
+    /**
+     * @brief blob: Returns the buffer holding every string back to back
+     * @return UTF-8 buffer of the strings
+     */
+    const SkiColumn<char> &blob() const;
+
+    /**
+     * @brief offsets: Returns the start offsets of the strings in blob().
+     *        There is one more offset than strings, the last one being the
+     *        end of the buffer.
+     * @return Offsets of the strings
+     */
+    const SkiColumn<quint32> &offsets() const;
+
+    /**
+     * @brief map: Makes the dictionary use a buffer and offsets earlier
+     *        written from blob() and offsets() without copying them
+     * @param blob: UTF-8 buffer of the strings
+     * @param blobSize: Size of the buffer in bytes
+     * @param offsets: Start offsets of the strings in the buffer
+     * @param offsetCount: Number of offsets
+     * @return False if the offsets don't describe a valid dictionary
+     * @pre Memory stays valid as long as the dictionary uses it
+     */
+    bool map(const char *blob, int blobSize, const quint32 *offsets,
+             int offsetCount);
+
+    /**
+     * @brief isMapped: Tells if the dictionary reads mapped memory
+     * @return True if the strings or their offsets are borrowed
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief detach: Copies mapped strings to memory owned by the dictionary
+     * @post Dictionary doesn't refer to mapped memory
+     */
+    void detach();
+
+private:
+    /**
+     * @brief buildLookup: Builds the string to id hash if it is not built.
+     *        Mapped dictionaries build it only when it is first needed.
+     */
+    void buildLookup() const;
+
+    SkiColumn<char>                    m_blob;
+    SkiColumn<quint32>                 m_offsets;
+    mutable QHash<QByteArray, quint32> m_lookup;
+    mutable bool                       m_lookupBuilt;
+};
+
+#endif // SKISTRINGDICTIONARY_H
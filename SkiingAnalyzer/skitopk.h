@@ -0,0 +1,76 @@
+#ifndef SKITOPK_H
+#define SKITOPK_H
+
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+/**
+ * @brief The SkiTopK class keeps the k smallest of the values pushed to it
+ *        in a bounded heap. Pushing a value takes O(log k) time and the
+ *        whole selection O(n log k) for n values. The order of equal values
+ *        is not defined, so values that may tie should include a tie breaker
+ *        in the comparison.
+ */
+template <typename T, typename Less = std::less<T>>
+class SkiTopK
+{
+public:
+    /**
+     * @brief SkiTopK: Creates an empty selection
+     * @param k: Number of values kept
+     * @param less: Comparison of two values
+     */
+    explicit SkiTopK(int k = 0, Less less = Less()) :
+        m_k(qMax(0, k)),
+        m_less(less)
+    {
+        m_heap.reserve(m_k);
+    }
+
+    /**
+     * @brief push: Offers a value to the selection
+     * @param value: Value that is kept if it is among the k smallest
+     */
+    void push(const T &value)
+    {
+        if(m_heap.size() < m_k){
+            m_heap.append(value);
+            std::push_heap(m_heap.begin(), m_heap.end(), m_less);
+        }
+        else if(m_k > 0 && m_less(value, m_heap.first())){
+            // The largest kept value is at the top of the heap
+            std::pop_heap(m_heap.begin(), m_heap.end(), m_less);
+            m_heap.last() = value;
+            std::push_heap(m_heap.begin(), m_heap.end(), m_less);
+        }
+    }
+
+    int size() const { return m_heap.size(); }
+    bool isFull() const { return m_heap.size() == m_k; }
+
+    /**
+     * @brief values: Returns the kept values
+     * @return The values in no particular order
+     */
+    const QVector<T> &values() const { return m_heap; }
+
+    /**
+     * @brief sorted: Returns the kept values in ascending order
+     * @return At most k smallest values
+     */
+    QVector<T> sorted() const
+    {
+        QVector<T> values = m_heap;
+        std::sort_heap(values.begin(), values.end(), m_less);
+        return values;
+    }
+
+private:
+    QVector<T> m_heap;
+    int        m_k;
+    Less       m_less;
+};
+
+#endif // SKITOPK_H
@@ -0,0 +1,421 @@
+#include "skitrace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Events after this many are only counted in the histograms, so a long
+// session can't run out of memory
+const int MaxEvents = 1000000;
+
+// Histograms have 2^SubBucketBits buckets for every power of two, so a
+// percentile is off by at most a quarter
+const int SubBucketBits = 2;
+const int SubBuckets = 1 << SubBucketBits;
+const int BucketCount = 64 * SubBuckets;
+
+const char *const TraceVariable = "SKIINGANALYZER_TRACE";
+
+/**
+ * @brief The Event struct holds one event of the Chrome trace. Phase is 'X'
+ *        for a span, 'b' and 'e' for the ends of a span that started
+ *        elsewhere and 'C' for a counter.
+ */
+struct Event {
+    const char *category;
+    const char *name;
+    char        phase;
+    int         thread;
+    qint64      time;
+    qint64      duration;
+    quint64     id;
+    qint64      value;
+};
+
+/**
+ * @brief The Histogram class counts samples in logarithmic buckets.
+ */
+class Histogram
+{
+public:
+    Histogram() :
+        m_count(0),
+        m_total(0),
+        m_min(std::numeric_limits<qint64>::max()),
+        m_max(std::numeric_limits<qint64>::min()),
+        m_buckets(BucketCount, 0)
+    {}
+
+    void add(qint64 sample)
+    {
+        ++m_count;
+        m_total += sample;
+        m_min = qMin(m_min, sample);
+        m_max = qMax(m_max, sample);
+        ++m_buckets[bucket(sample)];
+    }
+
+    void merge(const Histogram &other)
+    {
+        m_count += other.m_count;
+        m_total += other.m_total;
+        m_min = qMin(m_min, other.m_min);
+        m_max = qMax(m_max, other.m_max);
+        for(int i = 0; i < BucketCount; ++i)
+            m_buckets[i] += other.m_buckets[i];
+    }
+
+    qint64 count() const { return m_count; }
+    qint64 total() const { return m_total; }
+    qint64 maximum() const { return m_max; }
+
+    qint64 percentile(int percent) const
+    {
+        const qint64 rank = (m_count * percent + 99) / 100;
+        qint64 seen = 0;
+        for(int i = 0; i < BucketCount; ++i){
+            seen += m_buckets[i];
+            if(seen >= qMax<qint64>(1, rank)){
+                // The middle of the bucket, within the samples seen
+                const qint64 low = lowerBound(i);
+                const qint64 middle = low + (lowerBound(i + 1) - low) / 2;
+                return qBound(m_min, middle, m_max);
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static int bucket(qint64 sample)
+    {
+        if(sample < SubBuckets)
+            return static_cast<int>(qMax<qint64>(0, sample));
+
+        const int power = 63 - qCountLeadingZeroBits(static_cast<quint64>(sample));
+        const int sub = static_cast<int>(sample >> (power - SubBucketBits)) & (SubBuckets - 1);
+        return power * SubBuckets + sub;
+    }
+
+    static qint64 lowerBound(int index)
+    {
+        if(index < SubBuckets)
+            return index;
+
+        const int power = index / SubBuckets;
+        const int sub = index % SubBuckets;
+        if(power >= 63)
+            return std::numeric_limits<qint64>::max();
+        return static_cast<qint64>(SubBuckets + sub) << (power - SubBucketBits);
+    }
+
+    qint64          m_count;
+    qint64          m_total;
+    qint64          m_min;
+    qint64          m_max;
+    QVector<qint64> m_buckets;
+};
+
+typedef QPair<const char *, const char *> SpanKey;
+
+/**
+ * @brief The TraceState struct holds everything recorded since start.
+ */
+struct TraceState {
+    QMutex                                 mutex;
+    QElapsedTimer                          clock;
+    QString                                filename;
+    QVector<Event>                         events;
+    qint64                                 dropped = 0;
+    QHash<SpanKey, Histogram>              spans;
+    QHash<const char *, qint64>            counters;
+    QHash<const char *, Histogram>         values;
+    QHash<QPair<QByteArray, quint64>, qint64> open;
+};
+
+Q_GLOBAL_STATIC(TraceState, traceState)
+
+std::atomic<int> nextThread(0);
+
+/**
+ * @brief threadNumber: Numbers the threads in the order they first record
+ * @return Number of the calling thread
+ */
+int threadNumber()
+{
+    static thread_local const int number = ++nextThread;
+    return number;
+}
+
+/**
+ * @brief appendEvent: Adds an event unless the trace is full
+ * @param state: Locked state of the trace
+ * @param event: Event to add
+ */
+void appendEvent(TraceState &state, const Event &event)
+{
+    if(state.events.size() < MaxEvents)
+        state.events.append(event);
+    else
+        ++state.dropped;
+}
+
+QByteArray microseconds(qint64 nanoseconds)
+{
+    return QByteArray::number(nanoseconds / 1000.0, 'f', 3);
+}
+
+QString milliseconds(qint64 nanoseconds)
+{
+    return QString::number(nanoseconds / 1000000.0, 'f', 3);
+}
+
+/**
+ * @brief tableRow: Formats a row of the summary
+ * @param cells: Name followed by the numbers of the row
+ * @return Line of the summary
+ */
+QString tableRow(const QStringList &cells)
+{
+    const int nameWidth = 28;
+    const int numberWidth = 10;
+
+    QString row = cells.first().leftJustified(nameWidth);
+    for(int i = 1; i < cells.size(); ++i)
+        row += cells[i].rightJustified(numberWidth);
+    return row + "\n";
+}
+
+/**
+ * @brief startFromEnvironment: Starts tracing when the application starts
+ *        if the trace variable is set. The trace is written and the summary
+ *        printed when the application quits.
+ */
+void startFromEnvironment()
+{
+    if(!qEnvironmentVariableIsSet(TraceVariable))
+        return;
+
+    SkiTrace::start(qEnvironmentVariable(TraceVariable));
+    qAddPostRoutine([](){
+        if(!SkiTrace::enabled())
+            return;
+
+        QTextStream err(stderr);
+        if(!SkiTrace::stop())
+            err << "Couldn't write the trace " << qEnvironmentVariable(TraceVariable) << "\n";
+        err << SkiTrace::summary();
+    });
+}
+
+}
+
+Q_COREAPP_STARTUP_FUNCTION(startFromEnvironment)
+
+std::atomic<bool> SkiTrace::s_enabled(false);
+
+void SkiTrace::start(const QString &filename)
+{
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    state.filename = filename;
+    state.events.clear();
+    state.dropped = 0;
+    state.spans.clear();
+    state.counters.clear();
+    state.values.clear();
+    state.open.clear();
+    state.clock.start();
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool SkiTrace::stop()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+
+    QString filename;
+    {
+        QMutexLocker locker(&traceState()->mutex);
+        filename = traceState()->filename;
+    }
+    return filename.isEmpty() || writeChromeTrace(filename);
+}
+
+bool SkiTrace::writeChromeTrace(const QString &filename)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+
+    // Names are literals of the instrumented code, so they aren't escaped
+    QByteArray line;
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for(int i = 0; i < state.events.size(); ++i){
+        const Event &event = state.events[i];
+        line = "{\"name\":\"";
+        line += event.name;
+        line += "\",\"ph\":\"";
+        line += event.phase;
+        line += "\",\"pid\":1,\"tid\":" + QByteArray::number(event.thread)
+              + ",\"ts\":" + microseconds(event.time);
+        if(event.category)
+            line += QByteArray(",\"cat\":\"") + event.category + "\"";
+        if(event.phase == 'X')
+            line += ",\"dur\":" + microseconds(event.duration);
+        else if(event.phase == 'C')
+            line += ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}";
+        else
+            line += ",\"id\":\"0x" + QByteArray::number(event.id, 16) + "\"";
+        line += i + 1 < state.events.size() ? "},\n" : "}\n";
+        file.write(line);
+    }
+    file.write("]}\n");
+    return file.error() == QFileDevice::NoError;
+}
+
+QString SkiTrace::summary()
+{
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+
+    // Literals of different files may have different addresses, so the
+    // histograms are merged by their text
+    QHash<QString, Histogram> spans;
+    for(auto it = state.spans.constBegin(); it != state.spans.constEnd(); ++it){
+        const QString name = QString::fromLatin1(it.key().first) + '/'
+                + QString::fromLatin1(it.key().second);
+        spans[name].merge(it.value());
+    }
+    QHash<QString, qint64> counters;
+    for(auto it = state.counters.constBegin(); it != state.counters.constEnd(); ++it)
+        counters[QString::fromLatin1(it.key())] += it.value();
+    QHash<QString, Histogram> values;
+    for(auto it = state.values.constBegin(); it != state.values.constEnd(); ++it)
+        values[QString::fromLatin1(it.key())].merge(it.value());
+
+    QString text;
+    text += "Trace summary, times in ms\n";
+    text += tableRow(QStringList() << "span" << "count" << "total" << "mean" << "p50"
+                                   << "p95" << "max");
+
+    // The spans that took the most time are listed first
+    QStringList names = spans.keys();
+    std::sort(names.begin(), names.end(), [&spans](const QString &a, const QString &b){
+        return spans[a].total() > spans[b].total();
+    });
+    for(const QString &name : names){
+        const Histogram &histogram = spans[name];
+        text += tableRow(QStringList() << name << QString::number(histogram.count())
+                                       << milliseconds(histogram.total())
+                                       << milliseconds(histogram.total() / histogram.count())
+                                       << milliseconds(histogram.percentile(50))
+                                       << milliseconds(histogram.percentile(95))
+                                       << milliseconds(histogram.maximum()));
+    }
+
+    names = counters.keys();
+    std::sort(names.begin(), names.end());
+    if(!names.isEmpty())
+        text += "\n" + tableRow(QStringList() << "counter" << "total");
+    for(const QString &name : names)
+        text += tableRow(QStringList() << name << QString::number(counters[name]));
+
+    names = values.keys();
+    std::sort(names.begin(), names.end());
+    if(!names.isEmpty())
+        text += "\n" + tableRow(QStringList() << "value" << "count" << "mean" << "p50"
+                                             << "p95" << "max");
+    for(const QString &name : names){
+        const Histogram &histogram = values[name];
+        text += tableRow(QStringList() << name << QString::number(histogram.count())
+                                       << QString::number(histogram.total() / histogram.count())
+                                       << QString::number(histogram.percentile(50))
+                                       << QString::number(histogram.percentile(95))
+                                       << QString::number(histogram.maximum()));
+    }
+
+    if(state.dropped > 0)
+        text += QString("\n%1 events weren't written to the trace\n").arg(state.dropped);
+    return text;
+}
+
+qint64 SkiTrace::now()
+{
+    return traceState()->clock.nsecsElapsed();
+}
+
+void SkiTrace::recordComplete(const char *category, const char *name, qint64 startTime)
+{
+    const qint64 endTime = now();
+    const int thread = threadNumber();
+
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    appendEvent(state, {category, name, 'X', thread, startTime, endTime - startTime, 0, 0});
+    state.spans[qMakePair(category, name)].add(endTime - startTime);
+}
+
+void SkiTrace::recordBegin(const char *category, const char *name, quint64 id)
+{
+    const qint64 time = now();
+    const int thread = threadNumber();
+
+    // A span that is already open keeps its start, so a retried request is
+    // timed from its first attempt
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    const QPair<QByteArray, quint64> key(name, id);
+    if(state.open.contains(key))
+        return;
+    state.open.insert(key, time);
+    appendEvent(state, {category, name, 'b', thread, time, 0, id, 0});
+}
+
+void SkiTrace::recordEnd(const char *category, const char *name, quint64 id)
+{
+    const qint64 time = now();
+    const int thread = threadNumber();
+
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    const auto it = state.open.find(qMakePair(QByteArray(name), id));
+    if(it == state.open.end())
+        return;
+    const qint64 startTime = it.value();
+    state.open.erase(it);
+    appendEvent(state, {category, name, 'e', thread, time, 0, id, 0});
+    state.spans[qMakePair(category, name)].add(time - startTime);
+}
+
+void SkiTrace::recordCount(const char *name, qint64 amount)
+{
+    const qint64 time = now();
+    const int thread = threadNumber();
+
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    qint64 &counter = state.counters[name];
+    counter += amount;
+    appendEvent(state, {nullptr, name, 'C', thread, time, 0, 0, counter});
+}
+
+void SkiTrace::recordValue(const char *name, qint64 value)
+{
+    TraceState &state = *traceState();
+    QMutexLocker locker(&state.mutex);
+    state.values[name].add(value);
+}
@@ -0,0 +1,168 @@
+#ifndef SKITRACE_H
+#define SKITRACE_H
+
+/**
+ * Tracing of the retrieval and the analyses. Code is instrumented with the
+ * SKI_TRACE_* macros, which expand to nothing unless the program is built
+ * with SKI_TRACE defined (qmake CONFIG+=ski_trace). A traced build records
+ * only after SkiTrace::start, which happens at startup when the
+ * SKIINGANALYZER_TRACE environment variable names the trace file. Until then
+ * every macro costs one relaxed load of a flag.
+ *
+ * SKI_TRACE_SPAN(category, name)     Times the rest of the enclosing scope
+ * SKI_TRACE_BEGIN(category, name, id) Starts a span that ends elsewhere
+ * SKI_TRACE_END(category, name, id)   Ends the span of the same name and id
+ * SKI_TRACE_COUNT(name, amount)      Adds to a counter
+ * SKI_TRACE_VALUE(name, value)       Adds a sample to a histogram
+ *
+ * Categories and names must be string literals, they are stored as pointers.
+ */
+
+#ifdef SKI_TRACE
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+ * @brief The SkiTrace class records spans, counters and histograms from any
+ *        thread. Recorded spans are written as a Chrome trace, which can be
+ *        opened in chrome://tracing or Perfetto, and every span name gets a
+ *        histogram of its durations for the summary.
+ */
+class SkiTrace
+{
+public:
+    /**
+     * @brief enabled: Tells if events are being recorded
+     * @return True between start and stop
+     */
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief start: Clears the recorded events and starts recording
+     * @param filename: File of the Chrome trace written by stop, or an empty
+     *        string to only keep the summary
+     */
+    static void start(const QString &filename = QString());
+
+    /**
+     * @brief stop: Stops recording and writes the trace file
+     * @return Boolean indicating if the trace file was written
+     */
+    static bool stop();
+
+    /**
+     * @brief writeChromeTrace: Writes the recorded events in the trace event
+     *        format of Chrome
+     * @param filename: Filename of the trace
+     * @return Boolean indicating if writing was successful
+     */
+    static bool writeChromeTrace(const QString &filename);
+
+    /**
+     * @brief summary: Returns a table of the span durations, the counters
+     *        and the histograms
+     * @return Text of the summary
+     */
+    static QString summary();
+
+    /**
+     * @brief now: Returns the time used in the events
+     * @return Nanoseconds since start
+     */
+    static qint64 now();
+
+    static void complete(const char *category, const char *name, qint64 startTime)
+    {
+        if(enabled())
+            recordComplete(category, name, startTime);
+    }
+
+    static void begin(const char *category, const char *name, quint64 id)
+    {
+        if(enabled())
+            recordBegin(category, name, id);
+    }
+
+    static void end(const char *category, const char *name, quint64 id)
+    {
+        if(enabled())
+            recordEnd(category, name, id);
+    }
+
+    static void count(const char *name, qint64 amount)
+    {
+        if(enabled())
+            recordCount(name, amount);
+    }
+
+    static void value(const char *name, qint64 value)
+    {
+        if(enabled())
+            recordValue(name, value);
+    }
+
+private:
+    static void recordComplete(const char *category, const char *name, qint64 startTime);
+    static void recordBegin(const char *category, const char *name, quint64 id);
+    static void recordEnd(const char *category, const char *name, quint64 id);
+    static void recordCount(const char *name, qint64 amount);
+    static void recordValue(const char *name, qint64 value);
+
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief The SkiTraceSpan class records a span from its construction to its
+ *        destruction. The clock is read only while tracing is enabled.
+ */
+class SkiTraceSpan
+{
+public:
+    SkiTraceSpan(const char *category, const char *name) :
+        m_category(category),
+        m_name(name),
+        m_start(SkiTrace::enabled() ? SkiTrace::now() : -1)
+    {}
+
+    ~SkiTraceSpan()
+    {
+        if(m_start >= 0)
+            SkiTrace::complete(m_category, m_name, m_start);
+    }
+
+private:
+    Q_DISABLE_COPY(SkiTraceSpan)
+
+    const char *m_category;
+    const char *m_name;
+    qint64      m_start;
+};
+
+#define SKI_TRACE_CONCAT_(a, b) a##b
+#define SKI_TRACE_CONCAT(a, b) SKI_TRACE_CONCAT_(a, b)
+
+#define SKI_TRACE_SPAN(category, name) \
+    const SkiTraceSpan SKI_TRACE_CONCAT(skiTraceSpan, __LINE__)(category, name)
+#define SKI_TRACE_BEGIN(category, name, id) SkiTrace::begin(category, name, id)
+#define SKI_TRACE_END(category, name, id) SkiTrace::end(category, name, id)
+#define SKI_TRACE_COUNT(name, amount) SkiTrace::count(name, amount)
+#define SKI_TRACE_VALUE(name, value) SkiTrace::value(name, value)
+
+#else
+
+#define SKI_TRACE_SPAN(category, name) do {} while(false)
+#define SKI_TRACE_BEGIN(category, name, id) do {} while(false)
+#define SKI_TRACE_END(category, name, id) do {} while(false)
+#define SKI_TRACE_COUNT(name, amount) do {} while(false)
+#define SKI_TRACE_VALUE(name, value) do {} while(false)
+
+#endif // SKI_TRACE
+
+#endif // SKITRACE_H
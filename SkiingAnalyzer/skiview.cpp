@@ -12,12 +12,24 @@ SkiView::SkiView(QWidget *parent) :
     m_view = ui->u_treeView;
 
     // indexes of the columns that can be soted in the UI
-    QVector<int> sortableColumns1 = QVector<int>() << 4 << 5 << 6 << 7 << 9;
-    QVector<int> sortableColumns2 = QVector<int>() << 1;
+    QVector<int> sortableColumns1 = QVector<int>() << 0 << 1 << 2 << 3 << 4 << 5
+                                                   << 6 << 7 << 8 << 9 << 10;
+    QVector<int> sortableColumns2 = QVector<int>() << 0 << 1 << 2 << 3 << 4 << 5;
+
+    // types of the columns tell how the columns are sorted
+    QVector<SkiModel::ColumnType> columnTypes1 = QVector<SkiModel::ColumnType>()
+            << SkiModel::IntegerColumn << SkiModel::TextColumn << SkiModel::TimeColumn
+            << SkiModel::IntegerColumn << SkiModel::TextColumn << SkiModel::TextColumn
+            << SkiModel::TextColumn << SkiModel::TextColumn << SkiModel::IntegerColumn
+            << SkiModel::TextColumn << SkiModel::DecimalColumn;
+    QVector<SkiModel::ColumnType> columnTypes2 = QVector<SkiModel::ColumnType>()
+            << SkiModel::IntegerColumn << SkiModel::TextColumn << SkiModel::IntegerColumn
+            << SkiModel::TextColumn << SkiModel::TimeColumn << SkiModel::TimeColumn;
 
     // Create models for all tabs and views and set them all up.
     m_model = new SkiModel(this);
     m_model->setSortableColumns(sortableColumns1);
+    m_model->setColumnTypes(columnTypes1);
     m_model->SetColumns(m_columns);
     m_view->setModel(m_model);
     m_view->setUniformRowHeights(true);
@@ -26,6 +38,7 @@ SkiView::SkiView(QWidget *parent) :
     m_compareModel1 = new SkiModel(this);
     m_compareModel1->SetColumns(m_columns);
     m_compareModel1->setSortableColumns(sortableColumns1);
+    m_compareModel1->setColumnTypes(columnTypes1);
     ui->u_compareView1->setModel(m_compareModel1);
     ui->u_compareView1->setUniformRowHeights(true);
     ui->u_compareView1->setSortingEnabled(true);
@@ -33,6 +46,7 @@ SkiView::SkiView(QWidget *parent) :
     m_compareModel2 = new SkiModel(this);
     m_compareModel2->SetColumns(m_columns);
     m_compareModel2->setSortableColumns(sortableColumns1);
+    m_compareModel2->setColumnTypes(columnTypes1);
     ui->u_compareView2->setModel(m_compareModel2);
     ui->u_compareView2->setUniformRowHeights(true);
     ui->u_compareView2->setSortingEnabled(true);
@@ -40,6 +54,7 @@ SkiView::SkiView(QWidget *parent) :
     m_bestModel = new SkiModel(this);
     m_bestModel->SetColumns(m_columns);
     m_bestModel->setSortableColumns(sortableColumns1);
+    m_bestModel->setColumnTypes(columnTypes1);
     ui->u_bestView->setModel(m_bestModel);
     ui->u_bestView->setUniformRowHeights(true);
     ui->u_bestView->setSortingEnabled(true);
@@ -47,18 +62,19 @@ SkiView::SkiView(QWidget *parent) :
     m_teamsModel = new SkiModel(this);
     m_teamsModel->SetColumns(m_teamsColumns);
     m_teamsModel->setSortableColumns(sortableColumns2);
+    m_teamsModel->setColumnTypes(columnTypes2);
     ui->u_teamsView->setModel(m_teamsModel);
     ui->u_teamsView->setUniformRowHeights(true);
     ui->u_teamsView->setSortingEnabled(true);
 
     // Make necessary connects.
-    connect(this, &SkiView::AddNewRow, m_model, &SkiModel::AddRow);
+    connect(this, &SkiView::AddNewResults, m_model, &SkiModel::AddResults);
     connect(ui->u_tabWidget, &QTabWidget::currentChanged, this, &SkiView::tabHasChanged);
 
-    connect(this, &SkiView::compare1AddRow, m_compareModel1, &SkiModel::AddRow);
-    connect(this, &SkiView::compare2AddRow, m_compareModel2, &SkiModel::AddRow);
-    connect(this, &SkiView::bestAddRow, m_bestModel, &SkiModel::AddRow);
-    connect(this, &SkiView::teamsAddRow, m_teamsModel, &SkiModel::AddRow);
+    connect(this, &SkiView::compare1AddRows, m_compareModel1, &SkiModel::AddRows);
+    connect(this, &SkiView::compare2AddRows, m_compareModel2, &SkiModel::AddRows);
+    connect(this, &SkiView::bestAddRows, m_bestModel, &SkiModel::AddRows);
+    connect(this, &SkiView::teamsAddRows, m_teamsModel, &SkiModel::AddRows);
 
     // Initialize some minor UI elements and set them up.
     ui->u_predictionText->setHidden(true);
@@ -123,18 +139,18 @@ void SkiView::clearDistribution() {
 void SkiView::clearTeams() { m_teamsModel->clearData(); }
 
 
-void SkiView::Addrow(QVector<QString> row)
+void SkiView::AddResults(SkiResultSetPtr results)
 {
-    emit AddNewRow(row);
+    emit AddNewResults(results);
 }
 
-void SkiView::showCompareData(QVector<QString> row, int model)
+void SkiView::showCompareData(QVector<QVector<QString>> rows, int model)
 {
     if (model == 1) {
-        emit compare1AddRow(row);
+        emit compare1AddRows(rows);
     }
     else {
-        emit compare2AddRow(row);
+        emit compare2AddRows(rows);
     }
 }
 
@@ -190,9 +206,9 @@ void SkiView::showTimesData(QVector<QString> row)
     m_timesLayout->addWidget(chartview);
 }
 
-void SkiView::showBestAthleteData(QVector<QString> row)
+void SkiView::showBestAthleteData(QVector<QVector<QString>> rows)
 {
-    emit bestAddRow(row);
+    emit bestAddRows(rows);
 }
 
 void SkiView::showNationalityDistributionData(QHash<QString, int> row)
@@ -229,9 +245,9 @@ void SkiView::showNationalityDistributionData(QHash<QString, int> row)
     ui->u_distTotalNumber->setText(QString::number(total));
 }
 
-void SkiView::showTeamsData(QVector<QString> row)
+void SkiView::showTeamsData(QVector<QVector<QString>> rows)
 {
-    emit teamsAddRow(row);
+    emit teamsAddRows(rows);
 }
 
 void SkiView::showPredictionData(QVector<QString> row)
@@ -64,21 +64,21 @@ public slots:
     void clearTeams();
 
     /**
-     * @brief Addrow slot receives data from SkiAnalyzer and shows it in the
-     *        view.
-     * @param row: the row of data to be added to the view.
+     * @brief AddResults slot receives a block of search results from
+     *        SkiAnalyzer and shows it in the view.
+     * @param results: the results to be added to the view.
      * @post model has been notified about new data.
      */
-    void Addrow(QVector<QString> row);
+    void AddResults(SkiResultSetPtr results);
 
     /**
      * @brief showCompareData slot shows compare data.
-     * @param row: the row of data to be added to the view.
-     * @param model tells which model should take the row's data
+     * @param rows: the rows of data to be added to the view.
+     * @param model tells which model should take the rows
      * @pre  param model has to be 1 or 2.
      * @post the right model has been notified about new data.
      */
-    void showCompareData(QVector<QString> row, int model);
+    void showCompareData(QVector<QVector<QString>> rows, int model);
 
     /**
      * @brief showCompareNumberOfParticipants slot shows the number of
@@ -98,11 +98,11 @@ public slots:
     void showTimesData(QVector<QString> row);
 
     /**
-     * @brief showBestAthleteData slot shows the best athlete's data.
-     * @param row: the row of data to be added to the view.
+     * @brief showBestAthleteData slot shows the best athletes' data.
+     * @param rows: the rows of data to be added to the view.
      * @post model has been notified about new data.
      */
-    void showBestAthleteData(QVector<QString> row);
+    void showBestAthleteData(QVector<QVector<QString>> rows);
 
     /**
      * @brief showNationalityDistributionData slot shows nationality
@@ -115,10 +115,10 @@ public slots:
 
     /**
      * @brief showTeamsData slot shows top ten teams.
-     * @param row: the row of data to be added to the view.
+     * @param rows: the rows of data to be added to the view.
      * @post model has been notified about new data.
      */
-    void showTeamsData(QVector<QString> row);
+    void showTeamsData(QVector<QVector<QString>> rows);
 
     /**
      * @brief showPredictionData slot shows the predicted winner.
@@ -160,36 +160,37 @@ public slots:
 
 signals:
     /**
-     * @brief AddNewRow signal sends new row data to search tab's SkiModel.
-     * @param row: the row of data to be added to the model.
+     * @brief AddNewResults signal sends new search results to search tab's
+     *        SkiModel.
+     * @param results: the results to be added to the model.
      */
-    void AddNewRow(QVector<QString> row);
+    void AddNewResults(SkiResultSetPtr results);
 
     /**
-     * @brief compare1AddRow signal sends new row data to compares tab's first
+     * @brief compare1AddRows signal sends new rows to compares tab's first
      *        SkiModel.
-     * @param row: the row of data to be added to the model.
+     * @param rows: the rows of data to be added to the model.
      */
-    void compare1AddRow(QVector<QString> row);
+    void compare1AddRows(QVector<QVector<QString>> rows);
 
     /**
-     * @brief compare2AddRow signal sends new row data to compares tab's
-     *        second SkiModel.
-     * @param row: the row of data to be added to the model.
+     * @brief compare2AddRows signal sends new rows to compares tab's second
+     *        SkiModel.
+     * @param rows: the rows of data to be added to the model.
      */
-    void compare2AddRow(QVector<QString> row);
+    void compare2AddRows(QVector<QVector<QString>> rows);
 
     /**
-     * @brief bestAddRow signal sends new row data to best tab's SkiModel.
-     * @param row: the row of data to be added to the model.
+     * @brief bestAddRows signal sends new rows to best tab's SkiModel.
+     * @param rows: the rows of data to be added to the model.
      */
-    void bestAddRow(QVector<QString> row);
+    void bestAddRows(QVector<QVector<QString>> rows);
 
     /**
-     * @brief teamsAddRow signal sends new row data to teams tab's SkiModel.
-     * @param row: the row of data to be added to the model.
+     * @brief teamsAddRows signal sends new rows to teams tab's SkiModel.
+     * @param rows: the rows of data to be added to the model.
      */
-    void teamsAddRow(QVector<QString> row);
+    void teamsAddRows(QVector<QVector<QString>> rows);
 
     /**
      * @brief tabHasChanged signal informs SkiQuestionsDock about tab change.
@@ -0,0 +1,65 @@
+#ifndef SKIYEARSCAN_H
+#define SKIYEARSCAN_H
+
+#include <QFuture>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#include "skitrace.h"
+
+/**
+ * @brief The SkiYearScan class runs a function for every year of a range.
+ *        Years are independent parts of the result store, so they can be
+ *        scanned on a thread pool. Results are always returned in year order
+ *        no matter in which order the threads finish.
+ */
+class SkiYearScan
+{
+public:
+    /**
+     * @brief map: Calls a function for every year and collects the results
+     * @param pool: Thread pool to run the years on, or nullptr to run them
+     *        one after another in the calling thread
+     * @param fromYear: First year
+     * @param toYear: Last year
+     * @param function: Function taking a year. It may only read data that
+     *        isn't modified until map returns.
+     * @return Results of the function in year order
+     */
+    template <typename Function>
+    static auto map(QThreadPool *pool, int fromYear, int toYear, Function function)
+        -> QVector<decltype(function(0))>
+    {
+        typedef decltype(function(0)) Result;
+        QVector<Result> results;
+        if(toYear < fromYear)
+            return results;
+        results.reserve(toYear - fromYear + 1);
+
+        if(!pool || pool->maxThreadCount() <= 1 || fromYear == toYear){
+            for(int year = fromYear; year <= toYear; ++year){
+                SKI_TRACE_SPAN("scan", "year");
+                results.append(function(year));
+            }
+            return results;
+        }
+
+        QVector<QFuture<Result>> futures;
+        futures.reserve(toYear - fromYear + 1);
+        for(int year = fromYear; year <= toYear; ++year){
+            futures.append(QtConcurrent::run(pool, [&function, year]() -> Result {
+                SKI_TRACE_SPAN("scan", "year");
+                return function(year);
+            }));
+        }
+
+        // Waiting for the futures in year order merges the results
+        // deterministically
+        for(QFuture<Result> &future : futures)
+            results.append(future.result());
+        return results;
+    }
+};
+
+#endif // SKIYEARSCAN_H
@@ -0,0 +1,89 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "skistandinserver.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("SkiingStandIn");
+
+    const SkiResultGenerator::Parameters defaults;
+    const SkiStandInServer::Options defaultOptions;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Serves result pages like the archive of Finlandia hiihto. Point "
+                "SkiingAnalyzer to it with the SKIINGANALYZER_URL environment variable.");
+    parser.addHelpOption();
+
+    const QCommandLineOption port("port", "Port to listen on, 0 for any free port.",
+                                  "port", "8080");
+    const QCommandLineOption pages("pages", "Directory of recorded pages, form.html and "
+                                   "<year>.html. Pages are generated if not given.",
+                                   "directory");
+    const QCommandLineOption firstYear("first-year", "First generated year.", "year",
+                                       QString::number(defaults.firstYear));
+    const QCommandLineOption lastYear("last-year", "Last generated year.", "year",
+                                      QString::number(defaults.lastYear));
+    const QCommandLineOption participants("participants", "Generated participants per race.",
+                                          "count", QString::number(defaults.participants));
+    const QCommandLineOption seed("seed", "Seed of the generated pages and the failures.",
+                                  "seed", QString::number(defaults.seed));
+    const QCommandLineOption latency("latency", "Delay before each response in milliseconds.",
+                                     "ms", QString::number(defaultOptions.latency));
+    const QCommandLineOption bandwidth("bandwidth", "Bytes per second of each response, "
+                                       "0 for no limit.", "bytes",
+                                       QString::number(defaultOptions.bandwidth));
+    const QCommandLineOption errorRate("error-rate", "Percentage of requests answered "
+                                       "with an error.", "percent",
+                                       QString::number(defaultOptions.errorRate));
+    const QCommandLineOption errorStatus("error-status", "HTTP status of the errors.",
+                                         "status", QString::number(defaultOptions.errorStatus));
+    const QCommandLineOption dropRate("drop-rate", "Percentage of responses cut off "
+                                      "halfway.", "percent",
+                                      QString::number(defaultOptions.dropRate));
+    const QCommandLineOption verbose("verbose", "Print every served request.");
+    parser.addOptions({port, pages, firstYear, lastYear, participants, seed, latency,
+                       bandwidth, errorRate, errorStatus, dropRate, verbose});
+    parser.process(a);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SkiResultGenerator::Parameters parameters;
+    parameters.firstYear = parser.value(firstYear).toInt();
+    parameters.lastYear = parser.value(lastYear).toInt();
+    parameters.participants = parser.value(participants).toInt();
+    parameters.seed = parser.value(seed).toULongLong();
+
+    SkiStandInServer::Options options;
+    options.latency = qMax(0, parser.value(latency).toInt());
+    options.bandwidth = qMax(0, parser.value(bandwidth).toInt());
+    options.errorRate = qBound(0, parser.value(errorRate).toInt(), 100);
+    options.errorStatus = parser.value(errorStatus).toInt();
+    options.dropRate = qBound(0, parser.value(dropRate).toInt(), 100);
+    options.seed = parser.value(seed).toUInt();
+
+    SkiStandInServer server(parameters);
+    server.setOptions(options);
+    if(parser.isSet(pages) && !server.setFixtureDirectory(parser.value(pages))){
+        err << "No form.html in " << parser.value(pages) << "\n";
+        return 1;
+    }
+    if(!server.listen(QHostAddress::LocalHost, parser.value(port).toUShort())){
+        err << "Couldn't listen: " << server.errorString() << "\n";
+        return 1;
+    }
+
+    if(parser.isSet(verbose)){
+        QObject::connect(&server, &SkiStandInServer::requestServed,
+                         [&out](const QByteArray &method, int year, int status){
+            out << method << ' ' << year << ' ' << status << endl;
+        });
+    }
+
+    out << "Listening on http://127.0.0.1:" << server.port() << "/Tulokset/Tulosarkisto" << endl;
+    return a.exec();
+}
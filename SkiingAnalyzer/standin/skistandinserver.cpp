@@ -0,0 +1,296 @@
+#include "skistandinserver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QPointer>
+#include <QRandomGenerator>
+
+#include <limits>
+
+namespace {
+
+// Throttled responses are written in slices at this interval
+const int ThrottleInterval = 10;
+
+const QByteArray HeaderEnd = "\r\n\r\n";
+const QByteArray YearField = "name=\"dnn$ctr1025$Etusivu$ddlVuosi2x\"";
+
+}
+
+SkiStandInServer::Options::Options() :
+    latency(0),
+    bandwidth(0),
+    errorRate(0),
+    errorStatus(503),
+    dropRate(0),
+    seed(1)
+{}
+
+SkiStandInServer::SkiStandInServer(const SkiResultGenerator::Parameters &parameters,
+                                   QObject *parent) :
+    QObject(parent),
+    m_generator(parameters),
+    m_requests(0),
+    m_errors(0),
+    m_drops(0)
+{
+    m_throttle.setInterval(ThrottleInterval);
+    connect(&m_server, &QTcpServer::newConnection,
+            this, &SkiStandInServer::acceptConnections);
+    connect(&m_throttle, &QTimer::timeout, this, &SkiStandInServer::writePending);
+}
+
+bool SkiStandInServer::setFixtureDirectory(const QString &path)
+{
+    m_fixtures = path;
+    return QFile::exists(QDir(path).filePath("form.html"));
+}
+
+void SkiStandInServer::setOptions(const Options &options)
+{
+    m_options = options;
+}
+
+bool SkiStandInServer::listen(const QHostAddress &address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+quint16 SkiStandInServer::port() const
+{
+    return m_server.serverPort();
+}
+
+QString SkiStandInServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+int SkiStandInServer::requests() const
+{
+    return m_requests;
+}
+
+int SkiStandInServer::errors() const
+{
+    return m_errors;
+}
+
+int SkiStandInServer::drops() const
+{
+    return m_drops;
+}
+
+void SkiStandInServer::acceptConnections()
+{
+    while(QTcpSocket *socket = m_server.nextPendingConnection()){
+        Connection connection;
+        connection.busy = false;
+        connection.drop = false;
+        connection.year = 0;
+        connection.status = 0;
+        m_connections.insert(socket, connection);
+
+        connect(socket, &QTcpSocket::readyRead, this, &SkiStandInServer::readRequests);
+        connect(socket, &QTcpSocket::disconnected, this, &SkiStandInServer::removeConnection);
+    }
+}
+
+void SkiStandInServer::readRequests()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if(!socket || !m_connections.contains(socket))
+        return;
+
+    m_connections[socket].buffer += socket->readAll();
+    handleRequest(socket);
+}
+
+void SkiStandInServer::handleRequest(QTcpSocket *socket)
+{
+    Connection &connection = m_connections[socket];
+    if(connection.busy)
+        return;
+
+    // Wait until the headers and the whole body have arrived
+    const int headerEnd = connection.buffer.indexOf(HeaderEnd);
+    if(headerEnd == -1)
+        return;
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    int contentLength = 0;
+    for(const QByteArray &line : lines){
+        const int colon = line.indexOf(':');
+        if(colon != -1 && line.left(colon).trimmed().toLower() == "content-length")
+            contentLength = line.mid(colon + 1).trimmed().toInt();
+    }
+
+    const int requestSize = headerEnd + HeaderEnd.size() + contentLength;
+    if(connection.buffer.size() < requestSize)
+        return;
+
+    const QByteArray body = connection.buffer.mid(headerEnd + HeaderEnd.size(), contentLength);
+    connection.buffer.remove(0, requestSize);
+    connection.busy = true;
+    connection.method = requestLine.value(0);
+    connection.year = connection.method == "POST" ? postedYear(body) : 0;
+    ++m_requests;
+
+    // The outcome depends on the page and on how many times it has been
+    // requested before
+    const int attempt = m_attempts[connection.year]++;
+    QRandomGenerator random({m_options.seed, static_cast<quint32>(connection.year),
+                             static_cast<quint32>(attempt)});
+    const int roll = static_cast<int>(random.bounded(100));
+
+    if(roll < m_options.errorRate){
+        ++m_errors;
+        respond(socket, m_options.errorStatus, "Injected error\n", false);
+        return;
+    }
+
+    const bool drop = roll < m_options.errorRate + m_options.dropRate;
+    if(drop)
+        ++m_drops;
+
+    QByteArray page;
+    if(connection.method == "GET"){
+        page = m_generator.formPage();
+        if(!m_fixtures.isEmpty()){
+            QFile file(QDir(m_fixtures).filePath("form.html"));
+            if(file.open(QIODevice::ReadOnly))
+                page = file.readAll();
+        }
+    }
+    else if(connection.method == "POST"){
+        page = resultPage(connection.year);
+    }
+    else{
+        respond(socket, 405, "Method not allowed\n", false);
+        return;
+    }
+    respond(socket, 200, page, drop);
+}
+
+void SkiStandInServer::respond(QTcpSocket *socket, int status, const QByteArray &body,
+                               bool drop)
+{
+    QByteArray reason = "Error";
+    if(status == 200)
+        reason = "OK";
+    else if(status == 405)
+        reason = "Method Not Allowed";
+    else if(status == 503)
+        reason = "Service Unavailable";
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n"
+            "Content-Type: text/html; charset=utf-8\r\n"
+            "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            "Connection: keep-alive\r\n\r\n" + body;
+
+    // A dropped response is cut off in the middle of the page
+    if(drop)
+        response.truncate(response.size() - body.size() / 2);
+
+    Connection &connection = m_connections[socket];
+    connection.drop = drop;
+    connection.status = drop ? 0 : status;
+
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(m_options.latency, this, [this, guard, response](){
+        if(!guard || !m_connections.contains(guard))
+            return;
+
+        // A running throttle sends the response with its next slice
+        m_connections[guard].pending = response;
+        if(!m_throttle.isActive())
+            writePending();
+    });
+}
+
+void SkiStandInServer::writePending()
+{
+    const int slice = m_options.bandwidth > 0
+            ? qMax(1, m_options.bandwidth * ThrottleInterval / 1000)
+            : std::numeric_limits<int>::max();
+
+    bool throttled = false;
+    for(QTcpSocket *socket : m_connections.keys()){
+        Connection &connection = m_connections[socket];
+        if(connection.pending.isEmpty())
+            continue;
+
+        const int size = qMin(slice, connection.pending.size());
+        socket->write(connection.pending.constData(), size);
+        connection.pending.remove(0, size);
+
+        if(connection.pending.isEmpty())
+            finishResponse(socket);
+        else
+            throttled = true;
+    }
+
+    if(throttled && !m_throttle.isActive())
+        m_throttle.start();
+    else if(!throttled)
+        m_throttle.stop();
+}
+
+void SkiStandInServer::finishResponse(QTcpSocket *socket)
+{
+    Connection &connection = m_connections[socket];
+    emit requestServed(connection.method, connection.year, connection.status);
+
+    if(connection.drop){
+        // The client sees the connection closing before the page has ended
+        socket->flush();
+        socket->abort();
+        return;
+    }
+
+    connection.busy = false;
+    handleRequest(socket);
+}
+
+void SkiStandInServer::removeConnection()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if(!socket)
+        return;
+
+    m_connections.remove(socket);
+    socket->deleteLater();
+}
+
+QByteArray SkiStandInServer::resultPage(int year) const
+{
+    if(m_fixtures.isEmpty())
+        return m_generator.page(year);
+
+    QFile file(QDir(m_fixtures).filePath(QString("%1.html").arg(year)));
+    if(file.open(QIODevice::ReadOnly))
+        return file.readAll();
+
+    // A year that wasn't recorded has no results
+    SkiResultGenerator::Parameters empty;
+    empty.firstYear = year;
+    empty.lastYear = year;
+    empty.participants = 0;
+    return SkiResultGenerator(empty).page(year);
+}
+
+int SkiStandInServer::postedYear(const QByteArray &body)
+{
+    // The value of a form field follows the headers of its part
+    int index = body.indexOf(YearField);
+    if(index == -1)
+        return 0;
+    index = body.indexOf(HeaderEnd, index);
+    if(index == -1)
+        return 0;
+    index += HeaderEnd.size();
+
+    const int end = body.indexOf("\r\n", index);
+    return body.mid(index, end == -1 ? -1 : end - index).trimmed().toInt();
+}
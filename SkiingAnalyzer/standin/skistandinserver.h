@@ -0,0 +1,157 @@
+#ifndef SKISTANDINSERVER_H
+#define SKISTANDINSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "skiresultgenerator.h"
+
+/**
+ * @brief The SkiStandInServer class is a small HTTP server that stands in
+ *        for the result archive of Finlandia hiihto. A get request returns
+ *        the search page with the form parameters and a post request returns
+ *        the result page of the year in the posted form. Pages are read from
+ *        a directory of recorded pages or generated by SkiResultGenerator.
+ *        Responses can be delayed, throttled and failed to measure the
+ *        retrieval. Failures are drawn from the seed, the page and the number
+ *        of times the page has been requested, so they don't depend on the
+ *        order in which concurrent requests arrive.
+ */
+class SkiStandInServer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief The Options struct holds how the responses are served.
+     */
+    struct Options {
+        int     latency;     // Delay before a response in milliseconds
+        int     bandwidth;   // Bytes per second of a response, 0 for no limit
+        int     errorRate;   // Percentage of responses that are errors
+        int     errorStatus; // HTTP status of the errors
+        int     dropRate;    // Percentage of responses cut off halfway
+        quint32 seed;
+
+        Options();
+    };
+
+    /**
+     * @brief SkiStandInServer: Creates a server of generated pages
+     * @param parameters: Parameters of the generated archive
+     * @param parent: Parent object
+     */
+    explicit SkiStandInServer(const SkiResultGenerator::Parameters &parameters,
+                              QObject *parent = nullptr);
+
+    /**
+     * @brief setFixtureDirectory: Serves recorded pages instead of generated
+     *        ones. The search page is read from form.html and the result
+     *        pages from <year>.html. A year without a page gets an empty
+     *        result page.
+     * @param path: Directory of the pages
+     * @return Boolean indicating if the directory has a search page
+     */
+    bool setFixtureDirectory(const QString &path);
+
+    void setOptions(const Options &options);
+
+    /**
+     * @brief listen: Starts accepting connections
+     * @param address: Address to listen on
+     * @param port: Port to listen on, 0 to choose a free port
+     * @return Boolean indicating if the server is listening
+     */
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 0);
+
+    quint16 port() const;
+    QString errorString() const;
+
+    int requests() const;
+    int errors() const;
+    int drops() const;
+
+signals:
+    /**
+     * @brief requestServed: Notifies that a response has been sent
+     * @param method: Method of the request
+     * @param year: Year of a post request, 0 for a get request
+     * @param status: HTTP status of the response, 0 if it was cut off
+     */
+    void requestServed(const QByteArray &method, int year, int status);
+
+private slots:
+    void acceptConnections();
+    void readRequests();
+    void writePending();
+    void removeConnection();
+
+private:
+    /**
+     * @brief The Connection struct holds the state of one client connection.
+     *        Requests on a connection are answered one at a time.
+     */
+    struct Connection {
+        QByteArray buffer;
+        QByteArray pending;
+        bool       busy;
+        bool       drop;
+        int        year;
+        int        status;
+        QByteArray method;
+    };
+
+    /**
+     * @brief handleRequest: Answers the next complete request of a
+     *        connection
+     * @param socket: Connection of the request
+     */
+    void handleRequest(QTcpSocket *socket);
+
+    /**
+     * @brief respond: Starts sending a response after the latency
+     * @param socket: Connection of the request
+     * @param status: HTTP status
+     * @param body: Body of the response
+     * @param drop: True to cut off the response halfway
+     */
+    void respond(QTcpSocket *socket, int status, const QByteArray &body, bool drop);
+
+    /**
+     * @brief finishResponse: Ends a sent response and starts the next
+     *        request of the connection
+     * @param socket: Connection of the response
+     */
+    void finishResponse(QTcpSocket *socket);
+
+    /**
+     * @brief resultPage: Returns the result page of a year
+     * @param year: Year of the page
+     * @return Page of the year
+     */
+    QByteArray resultPage(int year) const;
+
+    /**
+     * @brief postedYear: Finds the year in a posted form
+     * @param body: Multipart body of the post request
+     * @return Year, or 0 if the form has no year
+     */
+    static int postedYear(const QByteArray &body);
+
+    SkiResultGenerator                 m_generator;
+    QString                            m_fixtures;
+    Options                            m_options;
+    QTcpServer                         m_server;
+    QTimer                             m_throttle;
+    QHash<QTcpSocket *, Connection>    m_connections;
+    QHash<int, int>                    m_attempts;
+    int                                m_requests;
+    int                                m_errors;
+    int                                m_drops;
+};
+
+#endif // SKISTANDINSERVER_H